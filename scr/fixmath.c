@@ -0,0 +1,195 @@
+#include "fixmath.h"
+
+// sin(2 pi i / 256) in Q1.15
+const q1_15_t fix_sin_table[256] PROGMEM = {
+	     0,    804,   1608,   2410,   3212,   4011,   4808,   5602,
+	  6393,   7179,   7962,   8739,   9512,  10278,  11039,  11793,
+	 12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,
+	 18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,
+	 23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790,
+	 27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+	 30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,
+	 32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757,
+	 32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,
+	 32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,
+	 30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683,
+	 27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+	 23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,
+	 18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279,
+	 12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,
+	  6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,
+	     0,   -804,  -1608,  -2410,  -3212,  -4011,  -4808,  -5602,
+	 -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+	-12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530,
+	-18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+	-23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+	-27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+	-30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971,
+	-32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+	-32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285,
+	-32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+	-30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+	-27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+	-23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868,
+	-18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+	-12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,
+	 -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,   -804
+};
+
+// atan(i / 32) in quarter angle steps, i = 0 .. 32 (0 .. 45 degrees)
+static const uint8_t PROGMEM fix_atan_table[33] = {
+	0, 5, 10, 15, 20, 25, 30, 35, 40, 45, 49, 54, 58, 63, 67, 71,
+	76, 80, 84, 87, 91, 95, 98, 102, 105, 108, 111, 114, 117, 120, 123, 125,
+	128
+};
+
+
+// Angle of min/max (0 .. 32 steps), max > 0
+static uint8_t fix_atan_ratio(uint16_t min, uint16_t max) {
+	// Keep min * 256 in 16 bits
+	while(max >= 256) {
+		min >>= 1;
+		max >>= 1;
+	}
+
+	uint16_t ratio = (min << 8) / max;	// 0 .. 256
+	uint8_t pos = ratio >> 3;
+	uint8_t frac = ratio & 7;
+	uint8_t angle = pgm_read_byte(&fix_atan_table[pos]);
+	if(frac) {
+		uint8_t next = pgm_read_byte(&fix_atan_table[pos + 1]);
+		angle += ((next - angle) * frac) >> 3;
+	}
+
+	return (angle + 2) >> 2;
+}
+
+uint8_t fix_atan2(int16_t y, int16_t x) {
+	uint16_t ax = x < 0 ? -(uint16_t)x : (uint16_t)x;
+	uint16_t ay = y < 0 ? -(uint16_t)y : (uint16_t)y;
+
+	if(ax == 0 && ay == 0) {
+		return 0;
+	}
+
+	// First octant, then mirrored into place
+	uint8_t angle;
+	if(ax >= ay) {
+		angle = fix_atan_ratio(ay, ax);
+	} else {
+		angle = 64 - fix_atan_ratio(ax, ay);
+	}
+
+	if(x < 0) {
+		angle = 128 - angle;
+	}
+	if(y < 0) {
+		angle = -angle;
+	}
+
+	return angle;
+}
+
+
+uint8_t fix_sqrt16(uint16_t x) {
+	uint16_t root = 0;
+	uint16_t bit = 1U << 14;
+
+	while(bit > x) {
+		bit >>= 2;
+	}
+
+	while(bit) {
+		if(x >= root + bit) {
+			x -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return root;
+}
+
+uint16_t fix_sqrt32(uint32_t x) {
+	uint32_t root = 0;
+	uint32_t bit = 1UL << 30;
+
+	while(bit > x) {
+		bit >>= 2;
+	}
+
+	while(bit) {
+		if(x >= root + bit) {
+			x -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return root;
+}
+
+
+#ifdef FIXMATH_BENCH
+
+#include <math.h>
+#include <avr/io.h>
+
+#define BENCH_RUNS 32
+
+// Keeps the compiler from dropping the measured calls
+static volatile float bench_float_sink;
+static volatile int16_t bench_fixed_sink;
+static volatile float bench_float_in = 0.7f;
+static volatile int16_t bench_fixed_in = 179;
+
+// Timer1 cycles for one run of the statement, minus the timing overhead
+#define BENCH(total, statement) do { \
+		uint16_t bench_start = TCNT1; \
+		statement; \
+		total += (uint16_t)(TCNT1 - bench_start) - bench_overhead; \
+	} while(0)
+
+void fixmath_bench(struct fixmath_bench_result *result) {
+	uint8_t tccr1b = TCCR1B;
+	TCCR1A = 0;
+	TCCR1B = (1 << CS10);
+
+	uint16_t bench_overhead = 0;
+	uint16_t empty = TCNT1;
+	bench_overhead = TCNT1 - empty;
+
+	uint32_t sin_float = 0, sin_fixed = 0, mul_float = 0, mul_fixed = 0;
+	uint32_t atan2_float = 0, atan2_fixed = 0, sqrt_float = 0, sqrt_fixed = 0;
+
+	for(uint8_t i = 0; i < BENCH_RUNS; i++) {
+		float f = bench_float_in + i;
+		int16_t q = bench_fixed_in + i;
+
+		BENCH(sin_float, bench_float_sink = sinf(f));
+		BENCH(sin_fixed, bench_fixed_sink = fix_sin(q));
+		BENCH(mul_float, bench_float_sink = f * bench_float_in);
+		BENCH(mul_fixed, bench_fixed_sink = fix_mul_q8_8(q, bench_fixed_in));
+		BENCH(atan2_float, bench_float_sink = atan2f(f, bench_float_in));
+		BENCH(atan2_fixed, bench_fixed_sink = fix_atan2(q, bench_fixed_in));
+		BENCH(sqrt_float, bench_float_sink = sqrtf(f));
+		BENCH(sqrt_fixed, bench_fixed_sink = fix_sqrt32((uint32_t)q * 1000));
+	}
+
+	TCCR1B = tccr1b;
+
+	result->sin_float = sin_float / BENCH_RUNS;
+	result->sin_fixed = sin_fixed / BENCH_RUNS;
+	result->mul_float = mul_float / BENCH_RUNS;
+	result->mul_fixed = mul_fixed / BENCH_RUNS;
+	result->atan2_float = atan2_float / BENCH_RUNS;
+	result->atan2_fixed = atan2_fixed / BENCH_RUNS;
+	result->sqrt_float = sqrt_float / BENCH_RUNS;
+	result->sqrt_fixed = sqrt_fixed / BENCH_RUNS;
+}
+
+#endif
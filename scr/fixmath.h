@@ -0,0 +1,92 @@
+#ifndef _FIXMATH_H_
+#define _FIXMATH_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// Fixed point types: Q8.8 for coordinates/scales, Q1.15 for sine and cosine
+typedef int16_t q8_8_t;
+typedef int16_t q1_15_t;
+
+// Constants, folded at compile time: Q8_8(1.5), Q1_15(0.25)
+#define Q8_8(x) ((q8_8_t)((x) * 256.0 + ((x) < 0 ? -0.5 : 0.5)))
+#define Q1_15(x) ((q1_15_t)((x) * 32767.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+// Angles are binary: 256 steps per turn, 64 = 90 degrees
+extern const q1_15_t fix_sin_table[256] PROGMEM;
+
+static inline q1_15_t fix_sin(uint8_t angle) {
+	return pgm_read_word(&fix_sin_table[angle]);
+}
+
+static inline q1_15_t fix_cos(uint8_t angle) {
+	return pgm_read_word(&fix_sin_table[(uint8_t)(angle + 64)]);
+}
+
+// Signed 16x16 -> 32 bit multiply on the hardware MUL, without the
+// libgcc call the compiler emits for (int32_t)a * b
+static inline int32_t fix_mul16(int16_t a, int16_t b) {
+#if defined(__AVR_HAVE_MUL__)
+	int32_t result;
+	uint8_t zero;
+	__asm__ (
+		"clr  %[zero]"        "\n\t"
+		"mul  %A[a], %A[b]"   "\n\t"
+		"movw %A[res], r0"    "\n\t"
+		"muls %B[a], %B[b]"   "\n\t"
+		"movw %C[res], r0"    "\n\t"
+		"mulsu %B[b], %A[a]"  "\n\t"
+		"sbc  %D[res], %[zero]" "\n\t"
+		"add  %B[res], r0"    "\n\t"
+		"adc  %C[res], r1"    "\n\t"
+		"adc  %D[res], %[zero]" "\n\t"
+		"mulsu %B[a], %A[b]"  "\n\t"
+		"sbc  %D[res], %[zero]" "\n\t"
+		"add  %B[res], r0"    "\n\t"
+		"adc  %C[res], r1"    "\n\t"
+		"adc  %D[res], %[zero]" "\n\t"
+		"clr  r1"
+		: [res] "=&r" (result), [zero] "=&r" (zero)
+		: [a] "a" (a), [b] "a" (b)
+	);
+	return result;
+#else
+	return (int32_t)a * b;
+#endif
+}
+
+static inline q8_8_t fix_mul_q8_8(q8_8_t a, q8_8_t b) {
+	return fix_mul16(a, b) >> 8;
+}
+
+static inline q1_15_t fix_mul_q1_15(q1_15_t a, q1_15_t b) {
+	return fix_mul16(a, b) >> 15;
+}
+
+// Integer (or any fixed point) value times a sine/cosine: r * sin(a)
+static inline int16_t fix_scale(int16_t value, q1_15_t factor) {
+	return fix_mul16(value, factor) >> 15;
+}
+
+// Angle of the vector (x, y), same convention as fix_sin/fix_cos:
+// fix_atan2(fix_sin(a), fix_cos(a)) == a (within one step)
+uint8_t fix_atan2(int16_t y, int16_t x);
+
+// Integer square roots, rounded down
+uint8_t fix_sqrt16(uint16_t x);
+uint16_t fix_sqrt32(uint32_t x);
+
+#ifdef FIXMATH_BENCH
+// Average cycles per call, soft float (libm) against fixed point.
+// Uses Timer1 at clk/1, build with -DFIXMATH_BENCH.
+struct fixmath_bench_result {
+	uint16_t sin_float, sin_fixed;
+	uint16_t mul_float, mul_fixed;
+	uint16_t atan2_float, atan2_fixed;
+	uint16_t sqrt_float, sqrt_fixed;
+};
+
+void fixmath_bench(struct fixmath_bench_result *result);
+#endif
+
+#endif
@@ -25,8 +25,6 @@
 //--------------------------Include(s)----------------------------------------------------------------
 #include <stdio.h>         // Allows us to perform input and output operations
 #include <avr/io.h>        // Includes the apropriate IO definition usage
-#include <util/delay.h>    // Includes the apropriate delay functions
-#include <math.h>          // Functions to compute common mathematical operations and transformations
 #include <avr/interrupt.h> // Includes the interrupt library & its functions
 #include <stdlib.h>        // Collection of functions for performing general purpose tasks
 #include <time.h>          // Collection of functions and macros for working with time and date
@@ -34,6 +32,23 @@
 #include "st7735.h"        // Library located in src folder
 #include "st7735_gfx.h"    // Library located in src folder
 #include "st7735_font.h"   // Library located in src folder
+#include "st7735_color.h"  // Library located in src folder
+#include "st7735_stamp.h"  // Library located in src folder
+#include "st7735_dirty.h"  // Library located in src folder
+#include "st7735_transition.h" // Library located in src folder
+#include "timebase.h"      // Library located in src folder
+#include "rng.h"           // Library located in src folder
+#include "task.h"          // Library located in src folder
+#include "st7735_perf.h"   // Library located in src folder
+#ifdef FIXMATH_BENCH
+#include "fixmath.h"       // Library located in src folder
+#endif
+#if defined(FIXMATH_BENCH) || defined(ST7735_ASYNC_BENCH)
+#include "st7735_console.h" // Library located in src folder
+#endif
+#ifdef ST7735_ASYNC_BENCH
+#include "st7735_async.h"  // Library located in src folder
+#endif
 #include "logo_bw.h"       // Library located in src folder
 #include "free_sans2.h"    // Library located in src folder
 //----------------------------------------------------------------------------------------------------
@@ -45,6 +60,24 @@ volatile uint16_t counter_time = 0; // Volatile so microcontroller knows it can/
 volatile int rand_on = 1;          // Volatile so microcontrolelr knows it can/will be changed
 volatile int sequence = 0;                  // The specific animation that will be shown
 
+// Color ramps for Animation 1 (red to yellow) and Animation 2 (green to cyan)
+static const uint16_t PROGMEM circle_ramp[16] = ST7735_RAMP16(0xFF0000, 0xFFE000);
+static const uint16_t PROGMEM rect_ramp[16] = ST7735_RAMP16(0x00FF00, 0x00FFFF);
+
+// 9x9 star used by Animation 4 (layout described in st7735_stamp.h)
+static const uint8_t PROGMEM star_stamp[] = {
+    9, 9,
+    0x80, 0x80, // X.......X
+    0x49, 0x00, // .X..X..X.
+    0x2A, 0x00, // ..X.X.X..
+    0x1C, 0x00, // ...XXX...
+    0x7F, 0x00, // .XXXXXXX.
+    0x1C, 0x00, // ...XXX...
+    0x2A, 0x00, // ..X.X.X..
+    0x49, 0x00, // .X..X..X.
+    0x80, 0x80  // X.......X
+};
+
 // Using External Interrupt Request 0 that will activate when the first pushbutton
 // is pressed and will reset the internal timer0 (Animation5)
 ISR(INT0_vect)
@@ -100,92 +133,114 @@ void init(void)
   TIMSK0 = (0 << OCIE0B) | (0 << OCIE0A) | (1 << TOIE0);
 }
 
-// Main Code
-int main(void)
+// Formats the running time (counted by timer0) as HH:MM:SS into buffer
+static void format_running_time(void)
 {
-  DDRD = 0b11111111; // All D pins becomes outputs
-  PORTD = 0b11111100;
-  DDRC = 0b00111111; // All C pins becomes outputs
+  uint16_t time_seconds = counter_time/31; // 0.03264 * counter_time
+  int hours = time_seconds / 3600;
+  int minutes = (time_seconds % 3600) / 60;
+  int seconds = (time_seconds % 3600) % 60;
 
-  EIMSK = (1 << INT1) | (1 << INT0); // External Interrupts INT0 & INT1 enabled
-  EICRA = EICRA = (1 << ISC11) | (0 << ISC10) |
-                  (1 << ISC01) | (0 << ISC00); // When a button is pressed it becomes an input
-  sei();                                       // Enables global interrupts
-
-  init();        // Runs the init code (line 85-99)
-  spi_init();    // Runs the init code in the external library spi.c
-  st7735_init(); // Runs the init code in the external library st7735.c
+  struct tm time_info = {0};
+  time_info.tm_hour = hours;
+  time_info.tm_min = minutes;
+  time_info.tm_sec = seconds;
+  strftime(buffer, 40, "%H:%M:%S", &time_info);
+}
 
-  // Decides if the Animation sequence will be random or not
-  int animation = 0;
+// Task state, the task functions lose their local variables at every wait
+struct animation_task_state
+{
+  struct task task;
+  int animation;    // Decides which animation is shown
+  int r;            // Circle (Animation 1) radius modification
+  int i;            // Rectanlge (Animation 2) position modification
+  int i2;           // For star (Animation 4) position modificaton
+  int c_animation5; // For star (Animation 5) color modification
+  struct st7735_transition transition; // Clears up after each animation
+};
+static struct animation_task_state animation_state;
 
-  st7735_set_orientation(ST7735_PORTRAIT);
-  // Covers the whole screen in black as bg color
-  st7735_fill_rect(0, 0, 128, 128, ST7735_COLOR_BLACK);
+// Clock widget in the bottom band, updated once a second next to the animations
+#define CLOCK_WIDGET_Y 110      // Top row of the band
+#define CLOCK_WIDGET_HEIGHT 18  // Glyphs reach 14 rows above the baseline
+#define PERF_TAG_CLOCK 5        // Telemetry tag of the widget, the animations use 0-4
+struct clock_widget_state
+{
+  struct task task;
+};
+static struct clock_widget_state clock_widget;
 
-  ADMUX = (0 << REFS1) | (1 << REFS0) | (0 << MUX3) | (0 << MUX2) | (0 << MUX1) | (0 << MUX0);
-  ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADPS2) | (1 << ADPS1) | (0 << ADPS0);
+// Runs a transition a step at a time, the clock keeps ticking in between
+// (only one per source line, it waits)
+#define TASK_TRANSITION(t, tr, type)                                 \
+  do                                                                 \
+  {                                                                  \
+    st7735_transition_begin(tr, type, ST7735_COLOR_BLACK, 400);     \
+    while (st7735_transition_step(tr))                               \
+      TASK_SLEEP_MS(t, st7735_transition_delay(tr));                 \
+  } while (0)
 
-  while (ADCSRA & (1 << ADSC))
-    ;
+// Shows the animations one after another (sequentially or in a random order)
+static enum TASK_STATE animation_task(struct task *t)
+{
+  struct animation_task_state *anim = (struct animation_task_state *)t;
 
+  TASK_BEGIN(t);
   while (1)
   {
-    // Covers the whole screen in black as bg color
-    st7735_fill_rect(0, 0, 128, 128, ST7735_COLOR_BLACK);
+    // Clears whatever the previous animation drew on
+    st7735_clear_dirty(ST7735_COLOR_BLACK);
     if (rand_on == 1)
     {
-      animation = rand() % 5; // Generates a random number between 0 and 4
+      anim->animation = rng_range(5); // Generates a random number between 0 and 4
     }
     else
     {
-      animation = sequence;    // Choose which animation will be shown
+      anim->animation = sequence; // Choose which animation will be shown
       sequence++;              // Increment sequence number
       sequence = sequence % 5; // Limits the chosen case between 0-4
     }
-    switch (animation)
+    switch (anim->animation)
     {
-      int r;            // Circle (Animation 1) radius modification
-      int i;            // Rectanlge (Animation 2) position modification
-      int16_t a, b;     // Smiley (Animation 3) parameters
-      int i2;           // For star (Animation 4) position modificaton
       int i3;           // For drawing star (Animation 5)
-      int c_animation5; // For star (Animation 5) color modification
 
     case 0: // Animation 1: Circle(s)
       PORTC |= (1 << PC5);
-      for (r = 0; r < 11; r++)
+      for (anim->r = 0; anim->r < 11; anim->r++)
       {
-        int radius = r * 5 + 10;                         // Increment radius by 5 pixels each iteration
-        int color_animation1 = ST7735_COLOR_RED + 1 * r; // Increment color by 1 each iteration
+        int radius = anim->r * 5 + 10;                         // Increment radius by 5 pixels each iteration
+        uint16_t color_animation1 = st7735_color_ramp(circle_ramp, anim->r * 3 / 2); // Next step of the ramp
         // Draws cirlce with specified color & radius at position (64,64)
         st7735_draw_circle(64, 64, radius, color_animation1);
-        _delay_ms(500);
+        st7735_perf_frame(anim->animation);
+        TASK_SLEEP_MS(t, 500);
       }
-      // Covers the whole screen in black as bg color
-      st7735_fill_rect(0, 0, 128, 128, ST7735_COLOR_BLACK);
+      // Clears the area the animation drew on with a transition
+      TASK_TRANSITION(t, &anim->transition, ST7735_TRANSITION_SCROLL);
       PORTC &= ~(1 << PC5);
       break;
 
     case 1: // ANIMATION 2: Rectangle(s)
       PORTC |= (1 << PC4);
-      for (i = 0; i < 12; i++)
+      for (anim->i = 0; anim->i < 12; anim->i++)
       {
-        int x = i * 5;                                      // Increment x by 5 pixels each iteration
-        int y = i * 5;                                      // Increment y by 5 pixels each iteration
-        int color_animation2 = ST7735_COLOR_GREEN + 10 * i; // Increment color by 10 each iteration
+        int x = anim->i * 5;                                     // Increment x by 5 pixels each iteration
+        int y = anim->i * 5;                                     // Increment y by 5 pixels each iteration
+        uint16_t color_animation2 = st7735_color_ramp(rect_ramp, anim->i * 15 / 11); // Next step of the ramp
         // Draws a 80x80 pixels rectanlge with specified color at position (x,y)
         st7735_draw_rect(x, y, 80, 80, color_animation2);
-        _delay_ms(500);
+        st7735_perf_frame(anim->animation);
+        TASK_SLEEP_MS(t, 500);
       }
-      // Covers the whole screen in black as bg color
-      st7735_fill_rect(0, 0, 128, 128, ST7735_COLOR_BLACK);
+      // Clears the area the animation drew on with a transition
+      TASK_TRANSITION(t, &anim->transition, ST7735_TRANSITION_COLUMN_WIPE);
       PORTC &= ~(1 << PC4);
       break;
 
     case 2: // Animation 3: A big star that grows
       PORTC |= (1 << PC3);
-      for (c_animation5 = 0; c_animation5 <= 14; c_animation5++)
+      for (anim->c_animation5 = 0; anim->c_animation5 <= 14; anim->c_animation5++)
       {
         const uint16_t color_animation5[] = {ST7735_COLOR_RED, ST7735_COLOR_GREEN, ST7735_COLOR_BLUE,
                                              ST7735_COLOR_YELLOW, ST7735_COLOR_BLUE, ST7735_COLOR_CYAN,
@@ -193,7 +248,7 @@ int main(void)
                                              ST7735_COLOR_GREEN, ST7735_COLOR_YELLOW, ST7735_COLOR_CYAN,
                                              ST7735_COLOR_MAGENTA, ST7735_COLOR_WHITE,
                                              ST7735_COLOR_BLACK};
-        int color = color_animation5[c_animation5];
+        int color = color_animation5[anim->c_animation5];
         for (i3 = 0; i3 < 50; i3++)
         {
           int l3;
@@ -215,60 +270,136 @@ int main(void)
           }
           st7735_draw_pixel(q, p, color);
         }
-        _delay_ms(100);
+        st7735_perf_frame(anim->animation);
+        TASK_SLEEP_MS(t, 100);
       }
+      // Clears the area the animation drew on with a transition
+      TASK_TRANSITION(t, &anim->transition, ST7735_TRANSITION_ROW_WIPE);
       PORTC &= ~(1 << PC3);
       break;
 
     case 3: // Animation 4: A lot of stars at random positions
       PORTC |= (1 << PC2);
-      for (i2 = 0; i2 < 50; i2++)
+      for (anim->i2 = 0; anim->i2 < 50; anim->i2++)
       {
-        int16_t x = rand() % 128;
-        int16_t y = rand() % 128;
-        int c_animation4, color_animation4;
-        for (c_animation4 = 0; c_animation4 < 5; c_animation4++)
-        {
-          color_animation4 = ST7735_COLOR_WHITE;
-          st7735_draw_pixel(x - c_animation4, y - c_animation4, color_animation4);
-          st7735_draw_pixel(x + c_animation4, y - c_animation4, color_animation4);
-          st7735_draw_pixel(x - c_animation4, y + c_animation4, color_animation4);
-          st7735_draw_pixel(x + c_animation4, y + c_animation4, color_animation4);
-        }
-        for (c_animation4 = 0; c_animation4 < 4; c_animation4++)
-        {
-          color_animation4 = ST7735_COLOR_WHITE;
-          st7735_draw_pixel(x - c_animation4, y, color_animation4);
-          st7735_draw_pixel(x + c_animation4, y, color_animation4);
-          st7735_draw_pixel(x, y - c_animation4, color_animation4);
-          st7735_draw_pixel(x, y + c_animation4, color_animation4);
-        }
-        st7735_draw_pixel(x, y, ST7735_COLOR_WHITE);
+        int16_t x = rng_range(128);
+        int16_t y = rng_range(128);
+        // Star is centered on (x,y)
+        st7735_draw_stamp(x - 4, y - 4, star_stamp, ST7735_COLOR_WHITE);
       }
-      _delay_ms(1000);
-      // Covers the whole screen in black as bg color
-      st7735_fill_rect(0, 0, 128, 128, ST7735_COLOR_BLACK);
+      // White stars look the same with 8 colors, slow the panel down meanwhile
+      st7735_set_power_mode(ST7735_POWER_IDLE);
+      st7735_perf_frame(anim->animation);
+      TASK_SLEEP_MS(t, 1000);
+      st7735_set_power_mode(ST7735_POWER_NORMAL);
+      // Clears the area the animation drew on with a transition (a flash
+      // would invert the clock widget too)
+      TASK_TRANSITION(t, &anim->transition, ST7735_TRANSITION_COLUMN_WIPE);
       PORTC &= ~(1 << PC2);
       break;
 
     case 4: // Animation 5: Digita clock that shows running time
       PORTC |= (1 << PC1);
-      uint16_t time_seconds = counter_time/31; // 0.03264 * counter_time
-      int hours = time_seconds / 3600;
-      int minutes = (time_seconds % 3600) / 60;
-      int seconds = (time_seconds % 3600) % 60;
-
-      struct tm time_info = {0};
-      time_info.tm_hour = hours;
-      time_info.tm_min = minutes;
-      time_info.tm_sec = seconds;
-      strftime(buffer, 40, "%H:%M:%S", &time_info);
-      st7735_draw_text(20, 64, buffer, &Open_Sans_Regular_20, 1, ST7735_COLOR_BLUE);
-      _delay_ms(5000);
-      // Covers the whole screen in black as bg color
-      st7735_fill_rect(0, 0, 128, 128, ST7735_COLOR_BLACK);
+      // The clock widget already shows it, only its band stays on
+      st7735_set_partial_area(CLOCK_WIDGET_Y, CLOCK_WIDGET_HEIGHT);
+      st7735_set_power_mode(ST7735_POWER_PARTIAL_IDLE);
+      st7735_perf_frame(anim->animation);
+      TASK_SLEEP_MS(t, 5000);
+      st7735_set_power_mode(ST7735_POWER_NORMAL);
       PORTC &= ~(1 << PC1);
       break;
     }
+    st7735_perf_frame(anim->animation); // The transition counts to the animation
+  }
+  TASK_END(t);
+}
+
+// Redraws the running time in its band once a second
+static enum TASK_STATE clock_task(struct task *t)
+{
+  TASK_BEGIN(t);
+  while (1)
+  {
+    // The band is outside the animations' clip rectangle, open it up while drawing
+    st7735_clip_push();
+    st7735_clip_set(0, CLOCK_WIDGET_Y, 128, CLOCK_WIDGET_HEIGHT);
+    st7735_fill_rect(0, CLOCK_WIDGET_Y, 128, CLOCK_WIDGET_HEIGHT, ST7735_COLOR_BLACK);
+    format_running_time();
+    st7735_draw_text(20, CLOCK_WIDGET_Y + 14, buffer, &Open_Sans_Regular_20, 1, ST7735_COLOR_BLUE);
+    st7735_clip_pop();
+    st7735_perf_frame(PERF_TAG_CLOCK);
+    TASK_SLEEP_MS(t, 1000);
   }
+  TASK_END(t);
+}
+
+// Main Code
+int main(void)
+{
+  DDRD = 0b11111111; // All D pins becomes outputs
+  PORTD = 0b11111100;
+  DDRC = 0b00111111; // All C pins becomes outputs
+
+  EIMSK = (1 << INT1) | (1 << INT0); // External Interrupts INT0 & INT1 enabled
+  EICRA = EICRA = (1 << ISC11) | (0 << ISC10) |
+                  (1 << ISC01) | (0 << ISC00); // When a button is pressed it becomes an input
+  sei();                                       // Enables global interrupts
+
+  init();          // Runs the init code (line 85-99)
+  timebase_init(); // Millisecond timer used to sleep between frames
+  st7735_perf_init(); // Per primitive costs sent over the UART (only with -DST7735_PERF)
+  spi_init();      // Runs the init code in the external library spi.c
+  st7735_init();   // Runs the init code in the external library st7735.c
+
+#ifdef ST7735_FIXED
+  // A build with a fixed orientation ignores any other one
+  _Static_assert(ST7735_ORIENTATION == ST7735_PORTRAIT, "main.c draws in portrait, build with -DST7735_ORIENTATION=ST7735_PORTRAIT");
+#endif
+  st7735_set_orientation(ST7735_PORTRAIT);
+
+#ifdef FIXMATH_BENCH
+  // Shows cycles per call, soft float against fixed point, for 10 seconds
+  struct fixmath_bench_result bench;
+  fixmath_bench(&bench);
+  st7735_console_init(0, ST7735_COLOR_WHITE, ST7735_COLOR_BLACK);
+  st7735_console_puts("cycles  float  fixed\n");
+  snprintf(buffer, 40, "sin    %6u %6u\n", bench.sin_float, bench.sin_fixed);
+  st7735_console_puts(buffer);
+  snprintf(buffer, 40, "mul    %6u %6u\n", bench.mul_float, bench.mul_fixed);
+  st7735_console_puts(buffer);
+  snprintf(buffer, 40, "atan2  %6u %6u\n", bench.atan2_float, bench.atan2_fixed);
+  st7735_console_puts(buffer);
+  snprintf(buffer, 40, "sqrt   %6u %6u\n", bench.sqrt_float, bench.sqrt_fixed);
+  st7735_console_puts(buffer);
+  timebase_sleep_ms(10000);
+  st7735_scroll_reset();
+#endif
+
+#ifdef ST7735_ASYNC_BENCH
+  // Shows full screen fills, synchronous against queued, for 10 seconds
+  struct st7735_async_bench_result async_bench;
+  st7735_async_bench(&async_bench);
+  st7735_console_init(0, ST7735_COLOR_WHITE, ST7735_COLOR_BLACK);
+  snprintf(buffer, 40, "fill sync  %5u ms\n", async_bench.sync_ms);
+  st7735_console_puts(buffer);
+  snprintf(buffer, 40, "fill async %5u ms\n", async_bench.async_ms);
+  st7735_console_puts(buffer);
+  snprintf(buffer, 40, "cpu free   %5u %%\n", async_bench.cpu_free);
+  st7735_console_puts(buffer);
+  timebase_sleep_ms(10000);
+  st7735_scroll_reset();
+#endif
+
+  // Covers the whole screen in black as bg color
+  st7735_fill_rect(0, 0, 128, 128, ST7735_COLOR_BLACK);
+  st7735_dirty_reset(); // Screen is known black, start tracking from here
+  // Animations (and their clearing) stay above the clock widget's band
+  st7735_clip_set(0, 0, 128, CLOCK_WIDGET_Y);
+
+  rng_init(); // Seeds the random numbers from ADC0 noise, different on every boot
+
+  // Both run side by side, the CPU sleeps whenever neither has work
+  task_add(&animation_state.task, animation_task);
+  task_add(&clock_widget.task, clock_task);
+  task_run();
 }
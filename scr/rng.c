@@ -0,0 +1,115 @@
+#include "rng.h"
+
+#include <avr/io.h>
+#include <util/atomic.h>
+
+static uint16_t rng_state16 = 0xACE1;
+static uint32_t rng_state32 = 0x2545F491UL;
+
+// Conversions mixed into the seed, each adds about a bit of noise
+#define RNG_SEED_SAMPLES 32
+// 16 ms watchdog periods timed with the CPU clock
+#define RNG_WDT_SAMPLES 8
+
+static inline uint32_t rng_mix(uint32_t seed, uint16_t value) {
+	// Rotate so the noisy LSBs end up all over the word
+	seed = (seed << 5) | (seed >> 27);
+	return seed ^ value;
+}
+
+void rng_init(void) {
+	uint32_t seed = 0;
+
+	// The watchdog runs from its own 128 kHz RC oscillator, which drifts
+	// and jitters against the system clock: the passes of a fixed loop
+	// per watchdog period differ from boot to boot. Interrupt mode without
+	// a handler, so interrupts stay off while polling (the timebase misses
+	// these ~130 ms).
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		WDTCSR = (1 << WDCE) | (1 << WDE);
+		WDTCSR = (1 << WDIF) | (1 << WDIE);
+
+		for(uint8_t i = 0; i < RNG_WDT_SAMPLES; i++) {
+			uint16_t passes = 0;
+			while(!(WDTCSR & (1 << WDIF))) {
+				passes++;
+			}
+			WDTCSR = (1 << WDIF) | (1 << WDIE);
+			seed = rng_mix(seed, passes);
+		}
+
+		WDTCSR = (1 << WDIF);
+	}
+
+	// ADC0 has to float: main.c drives all of port C, take PC0 back for
+	// the conversions
+	uint8_t ddrc = DDRC;
+	uint8_t portc = PORTC;
+	DDRC &= ~(1 << DDC0);
+	PORTC &= ~(1 << PC0);
+
+	// ADC0 against AVcc, clk/64
+	ADMUX = (1 << REFS0);
+	ADCSRA = (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1);
+
+	for(uint8_t i = 0; i < RNG_SEED_SAMPLES; i++) {
+		ADCSRA |= (1 << ADSC);
+		while(ADCSRA & (1 << ADSC))
+			;
+
+		uint8_t low = ADCL;
+		(void)ADCH;	// ADCL locks the result until ADCH is read
+		seed = rng_mix(seed, low ^ ((uint16_t)TCNT2 << 8));
+	}
+	seed ^= (uint32_t)TCNT0 << 16;
+
+	ADCSRA = 0;
+	PORTC = (PORTC & ~(1 << PC0)) | (portc & (1 << PC0));
+	DDRC = (DDRC & ~(1 << DDC0)) | (ddrc & (1 << DDC0));
+
+	rng_seed(seed);
+}
+
+void rng_seed(uint32_t seed) {
+	// Xorshift never leaves (or reaches) 0
+	rng_state32 = seed ? seed : 0x2545F491UL;
+	rng_state16 = (uint16_t)seed ^ (uint16_t)(seed >> 16);
+	if(!rng_state16) {
+		rng_state16 = 0xACE1;
+	}
+}
+
+uint16_t rng_next16(void) {
+	// Shift triple (7, 9, 8): full period of 2^16 - 1
+	uint16_t x = rng_state16;
+	x ^= x << 7;
+	x ^= x >> 9;
+	x ^= x << 8;
+	return rng_state16 = x;
+}
+
+uint32_t rng_next32(void) {
+	// Marsaglia's (13, 17, 5): full period of 2^32 - 1
+	uint32_t x = rng_state32;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return rng_state32 = x;
+}
+
+uint16_t rng_range(uint16_t n) {
+	uint32_t m = (uint32_t)rng_next16() * n;
+	uint16_t low = m;
+
+	if(low < n) {
+		// 2^16 mod n values of low are one draw too many, only here is
+		// the division needed
+		uint16_t threshold = (uint16_t)-n % n;
+		while(low < threshold) {
+			m = (uint32_t)rng_next16() * n;
+			low = m;
+		}
+	}
+
+	return m >> 16;
+}
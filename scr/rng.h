@@ -0,0 +1,27 @@
+#ifndef _RNG_H_
+#define _RNG_H_
+
+#include <stdint.h>
+
+// Xorshift generators, much cheaper than libc rand() (no 32 bit multiply
+// and division per call). Not for anything that needs to be secure.
+
+// Seeds both generators from the jitter of the watchdog oscillator
+// against the CPU clock, the LSBs of ADC0 conversions and the Timer0 and
+// Timer2 counters, so every boot starts somewhere else. PC0 is made a
+// floating input for the conversions and set back afterwards, leave
+// nothing driving it; the ADC and the watchdog are off again when done.
+// Takes about 130 ms with interrupts off.
+void rng_init(void);
+
+// Seeds both generators with a fixed value (0 is replaced), for repeatable runs
+void rng_seed(uint32_t seed);
+
+uint16_t rng_next16(void);
+uint32_t rng_next32(void);
+
+// Uniform in 0 .. n - 1 without modulo bias: the high half of
+// rng_next16() * n, redrawing the few values that would favour low results
+uint16_t rng_range(uint16_t n);
+
+#endif
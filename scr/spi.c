@@ -1,11 +1,115 @@
 #include "spi.h"
 
+// SPR1:0 and SPI2X for the divider
+#if SPI_DIVIDER == 2
+#define SPI_SPCR_RATE 0
+#define SPI_SPSR_RATE (1 << SPI2X)
+#elif SPI_DIVIDER == 4
+#define SPI_SPCR_RATE 0
+#define SPI_SPSR_RATE 0
+#elif SPI_DIVIDER == 8
+#define SPI_SPCR_RATE (1 << SPR0)
+#define SPI_SPSR_RATE (1 << SPI2X)
+#elif SPI_DIVIDER == 16
+#define SPI_SPCR_RATE (1 << SPR0)
+#define SPI_SPSR_RATE 0
+#elif SPI_DIVIDER == 32
+#define SPI_SPCR_RATE (1 << SPR1)
+#define SPI_SPSR_RATE (1 << SPI2X)
+#elif SPI_DIVIDER == 64
+#define SPI_SPCR_RATE (1 << SPR1)
+#define SPI_SPSR_RATE 0
+#elif SPI_DIVIDER == 128
+#define SPI_SPCR_RATE ((1 << SPR1) | (1 << SPR0))
+#define SPI_SPSR_RATE 0
+#else
+#error "SPI_DIVIDER has to be 2, 4, 8, 16, 32, 64 or 128"
+#endif
+
+// Cycles from one SPDR write to the next. The shift register takes
+// SPI_BYTE_CYCLES, writing any earlier is a collision (byte dropped);
+// the extra cycles cover the SCK phase the write lands in.
+#define SPI_KERNEL_CYCLES (SPI_BYTE_CYCLES + 2)
+
+#ifdef ST7735_PERF
+uint32_t spi_bytes = 0;
+#endif
+
 void spi_init(void) {
 	// Set MOSI and SCK, SS/CS output, all others input
 	DDRB = (1<<PB3) | (1<<PB5) | (1<<PB2);
-	// Enable SPI, Master, set clock rate fck/4, mode 0
-	SPCR = (1<<SPE) | (1<<MSTR);
+	// Enable SPI, Master, set clock rate fck/SPI_DIVIDER, mode 0
+	SPCR = (1<<SPE) | (1<<MSTR) | SPI_SPCR_RATE;
+	SPSR = SPI_SPSR_RATE;
 
 	// Set SS/CS
 	PORTB |= (1 << PB2);
 }
+
+#if defined(__AVR__) && SPI_DIVIDER <= 16
+
+// Busy wait of exactly n cycles (constant): 3 cycle loop passes, then nops
+#define SPI_PAD(n) \
+	".if (" #n ") / 3\n\t" \
+	"ldi %[tmp], (" #n ") / 3\n" \
+	"0:\n\t" \
+	"dec %[tmp]\n\t" \
+	"brne 0b\n\t" \
+	".endif\n\t" \
+	".rept (" #n ") %% 3\n\t" \
+	"nop\n\t" \
+	".endr\n\t"
+
+#define SPI_PAD_EXPAND(n) SPI_PAD(n)
+
+void spi_write_repeat16(uint16_t word, uint16_t count) {
+	if(!count) {
+		return;
+	}
+
+	uint8_t tmp;
+	SPI_COUNT_BYTES(2 * (uint32_t)count);
+	count--;	// the last pixel goes out in the tail
+
+	__asm__ volatile (
+		"sbiw %[count], 0\n\t"
+		"breq 2f\n"
+	"1:\n\t"
+		"out %[spdr], %B[word]\n\t"
+		SPI_PAD_EXPAND(SPI_KERNEL_CYCLES - 1)
+		"out %[spdr], %A[word]\n\t"
+		// less the 4 cycles of loop counting
+		SPI_PAD_EXPAND(SPI_KERNEL_CYCLES - 5)
+		"sbiw %[count], 1\n\t"
+		"brne 1b\n\t"
+		"nop\n"	// brne not taken is a cycle short
+	"2:\n\t"
+		// Last pixel: SPSR is read with SPIF set by the previous byte, so
+		// the final SPDR write clears it and SPIF means done again
+		"out %[spdr], %B[word]\n\t"
+		SPI_PAD_EXPAND(SPI_KERNEL_CYCLES - 1)
+		"in %[tmp], %[spsr]\n\t"
+		"out %[spdr], %A[word]\n"
+	"3:\n\t"
+		"in %[tmp], %[spsr]\n\t"
+		"sbrs %[tmp], %[spif]\n\t"
+		"rjmp 3b\n\t"
+		: [count] "+w" (count), [tmp] "=&d" (tmp)
+		: [word] "r" (word),
+		  [spdr] "I" (_SFR_IO_ADDR(SPDR)),
+		  [spsr] "I" (_SFR_IO_ADDR(SPSR)),
+		  [spif] "I" (SPIF)
+	);
+}
+
+#else
+
+// Slow clocks gain nothing from a schedule (and host builds have no AVR asm)
+void spi_write_repeat16(uint16_t word, uint16_t count) {
+	while(count--) {
+		spi_write(word >> 8);
+		spi_write(word);
+	}
+}
+
+#endif
@@ -3,20 +3,33 @@
 
 #include<avr/io.h>
 
+// SCK = F_CPU / SPI_DIVIDER, one of 2, 4, 8, 16, 32, 64 or 128
+#ifndef SPI_DIVIDER
+#define SPI_DIVIDER 4
+#endif
+
+// CPU cycles one byte takes on the bus
+#define SPI_BYTE_CYCLES (8 * SPI_DIVIDER)
+
+#ifdef ST7735_PERF
+// Bytes sent so far, for st7735_perf
+extern uint32_t spi_bytes;
+#define SPI_COUNT_BYTES(n) (spi_bytes += (n))
+#else
+#define SPI_COUNT_BYTES(n)
+#endif
+
 void spi_init(void);
 
 static inline void spi_write(uint8_t byte) {
+	SPI_COUNT_BYTES(1);
 	SPDR = byte;
 	while(!(SPSR & (1<<SPIF)));
 }
 
-static inline void spi_set_cs(void) {
-	PORTB |= (1 << PB2);
-}
-
-static inline void spi_unset_cs(void) {
-	PORTB &= ~(1 << PB2);
-}
-
+// Sends word (MSB first) count times. SPDR is written on a fixed cycle
+// schedule instead of polling SPIF per byte; only the last byte is
+// waited for, as in spi_write. No interrupt may use SPI meanwhile.
+void spi_write_repeat16(uint16_t word, uint16_t count);
 
 #endif
@@ -4,78 +4,223 @@
 #include <avr/pgmspace.h>
 
 #include "spi.h"
+#include "st7735_async.h"
+#include "st7735_dirty.h"
 #include "st7735initcmds.h"
 
-uint8_t st7735_screen_row_start = 0;
-uint8_t st7735_screen_column_start = 0;
-uint8_t st7735_row_start = 0;
-uint8_t st7735_column_start = 0;
+#ifndef ST7735_FIXED
 uint8_t st7735_width = 0;
 uint8_t st7735_height = 0;
-enum ST7735_ORIENTATION st7735_orientation = ST7735_LANDSCAPE;
+#endif
+
+struct st7735_panel st7735_panel_default = {
+	.cs_port = &PORTB, .cs_mask = (1 << PB2),
+	.rs_port = &PORTB, .rs_mask = (1 << PB0),
+	.rst_port = &PORTB, .rst_mask = (1 << PB1),
+	.type = ST7735_DEFAULT_TYPE,
+	.orientation = ST7735_LANDSCAPE
+};
+
+static struct st7735_panel *st7735_cur = &st7735_panel_default;
+
+// GRAM rows of the controller, the panel shows st7735_height of them
+static const uint8_t st7735_gram_height = 162;
+static const uint8_t st7735_gram_width = 132;
+
+enum ST7735_MADCTL_ARGS {
+	MADCTL_MY = 0x80,	// Mirror Y
+	MADCTL_MX = 0x40,	// Mirrror x
+	MADCTL_MV = 0x20,	// Swap XY
+	MADCTL_ML = 0x10,	// Scan address order
+	MADCTL_RGB = 0x00,
+	MADCTL_BGR = 0x08,
+	MADCTL_MH = 0x04 	// Horizontal scan oder
+};
+
+// Panel properties, constants for ST7735_TYPE / ST7735_FIXED builds
+static inline enum ST7735_DISPLAY_TYPE st7735_panel_type(const struct st7735_panel *panel) {
+#ifdef ST7735_TYPE
+	(void)panel;
+	return ST7735_TYPE;
+#else
+	return panel->type;
+#endif
+}
+
+// GRAM offsets in portrait
+static inline uint8_t st7735_type_row_start(enum ST7735_DISPLAY_TYPE type) {
+	switch(type) {
+		case ST7735_RED_18_GREENTAB:
+			return 1;
+		case ST7735_RED144_GREENTAB:
+			return 3;
+		case ST7735_RED144_JAYCAR:
+			return 32;
+		default:
+			return 0;
+	}
+}
+
+static inline uint8_t st7735_type_column_start(enum ST7735_DISPLAY_TYPE type) {
+	return type == ST7735_RED_18_GREENTAB || type == ST7735_RED144_GREENTAB ? 2 : 0;
+}
+
+static inline uint8_t st7735_is_landscape(enum ST7735_ORIENTATION orientation) {
+	return orientation == ST7735_LANDSCAPE || orientation == ST7735_LANDSCAPE_INV;
+}
+
+static inline uint8_t st7735_orientation_madctl(enum ST7735_DISPLAY_TYPE type, enum ST7735_ORIENTATION orientation) {
+	uint8_t order = type == ST7735_RED_18_BLACKTAB ? MADCTL_RGB : MADCTL_BGR;
+
+	switch(orientation) {
+		case ST7735_PORTRAIT:
+			return MADCTL_MX | MADCTL_MY | order;
+		case ST7735_LANDSCAPE:
+			return MADCTL_MY | MADCTL_MV | order;
+		case ST7735_PORTRAIT_INV:
+			return order;
+		default:
+			return MADCTL_MX | MADCTL_MV | order;
+	}
+}
+
+#ifdef ST7735_FIXED
+static inline uint8_t st7735_madctl(void) {
+	return st7735_orientation_madctl(ST7735_TYPE, ST7735_ORIENTATION);
+}
+
+static inline uint8_t st7735_row_start(void) {
+	uint8_t start = st7735_is_landscape(ST7735_ORIENTATION) ?
+		st7735_type_column_start(ST7735_TYPE) : st7735_type_row_start(ST7735_TYPE);
+	return start + st7735_cur->row_start;
+}
+
+static inline uint8_t st7735_column_start(void) {
+	return st7735_is_landscape(ST7735_ORIENTATION) ?
+		st7735_type_row_start(ST7735_TYPE) : st7735_type_column_start(ST7735_TYPE);
+}
+#else
+static inline uint8_t st7735_madctl(void) {
+	return st7735_cur->madctl;
+}
+
+static inline uint8_t st7735_row_start(void) {
+	return st7735_cur->row_start;
+}
+
+static inline uint8_t st7735_column_start(void) {
+	return st7735_cur->column_start;
+}
+#endif
+
+struct st7735_clip st7735_clip;
+static struct st7735_clip st7735_clip_stack[ST7735_CLIP_DEPTH];
+static uint8_t st7735_clip_depth = 0;
 
+// Port writes go through the selected panel's pins (read-modify-write,
+// no interrupt may touch these ports)
 static inline void st7735_set_rs(void) {
-	PORTB |= (1 << PB0);
+	*st7735_cur->rs_port |= st7735_cur->rs_mask;
 }
 
 static inline void st7735_unset_rs(void) {
-	PORTB &= ~(1 << PB0);
+	*st7735_cur->rs_port &= ~st7735_cur->rs_mask;
 }
 
-static inline void st7735_set_rst(void) {
-	PORTB |= (1 << PB1);
+static inline void st7735_cs_high(void) {
+	*st7735_cur->cs_port |= st7735_cur->cs_mask;
 }
 
-static inline void st7735_unset_rst(void) {
-	PORTB &= ~(1 << PB1);
+static inline void st7735_cs_low(void) {
+	*st7735_cur->cs_port &= ~st7735_cur->cs_mask;
 }
 
 static inline void st7735_write_cmd(enum ST7735_COMMANDS cmd) {
+#ifdef ST7735_ASYNC
+	// The SPI belongs to the queued pixels until they are through
+	if(st7735_async_jobs) {
+		st7735_async_flush();
+	}
+#endif
 	st7735_unset_rs();
 
-	spi_unset_cs();
+	st7735_cs_low();
 	spi_write(cmd);
-	spi_set_cs();
+	st7735_cs_high();
 }
 
 static inline void st7735_write_data(uint8_t data) {
 	st7735_set_rs();
 
-	spi_unset_cs();
+	st7735_cs_low();
 	spi_write(data);
-	spi_set_cs();
+	st7735_cs_high();
 }
 
-static inline void st7735_write_color(uint16_t color) {
-	spi_write(color >> 8);
-	spi_write(color);
+
+void st7735_panel_setup(struct st7735_panel *panel, enum ST7735_DISPLAY_TYPE type,
+	volatile uint8_t *cs_port, uint8_t cs_pin,
+	volatile uint8_t *rs_port, uint8_t rs_pin,
+	volatile uint8_t *rst_port, uint8_t rst_pin) {
+	*panel = (struct st7735_panel) {
+		.cs_port = cs_port, .cs_mask = (1 << cs_pin),
+		.rs_port = rs_port, .rs_mask = (1 << rs_pin),
+		.rst_port = rst_port, .rst_mask = (1 << rst_pin),
+		.type = type,
+		.orientation = ST7735_LANDSCAPE
+	};
 }
 
+void st7735_select(struct st7735_panel *panel) {
+	if(panel == st7735_cur) {
+		return;
+	}
 
-static inline void st7735_reset(void) {
-	spi_unset_cs();
-	st7735_set_rst();
-	_delay_ms(500);
-	st7735_unset_rst();
-	_delay_ms(500);
-	st7735_set_rst();
-	_delay_ms(500);
+#ifndef ST7735_FIXED
+	st7735_cur->width = st7735_width;
+	st7735_cur->height = st7735_height;
+#endif
+	st7735_cur->clip = st7735_clip;
+	st7735_cur->dirty = st7735_dirty;
+
+	st7735_cur = panel;
+#ifndef ST7735_FIXED
+	st7735_width = panel->width;
+	st7735_height = panel->height;
+#endif
+	st7735_clip = panel->clip;
+	st7735_dirty = panel->dirty;
+}
+
+struct st7735_panel *st7735_selected(void) {
+	return st7735_cur;
 }
 
 
-void st7735_run_command_list(const uint8_t *addr) {
+// Panels being initialized together, the command lists go to each of them
+static struct st7735_panel *const *st7735_group;
+static uint8_t st7735_group_count;
+
+static void st7735_run_command_list(const uint8_t *addr) {
 	uint8_t  cmd_count, arg_count, has_delay;
 
 	cmd_count = pgm_read_byte(addr++);   // Number of commands to follow
 	for(uint8_t cmd_pos = 0; cmd_pos < cmd_count; cmd_pos++) {
-		st7735_write_cmd(pgm_read_byte(addr++)); 	// Read, send command
+		uint8_t cmd = pgm_read_byte(addr++);
 		arg_count  = pgm_read_byte(addr++);    		// Number of args to follow
 		has_delay = arg_count & DELAY_FLAG;         // If set, delay follows args
 		arg_count &= ~DELAY_FLAG;                  	// Number of args
-		for(uint8_t arg_pos = 0; arg_pos < arg_count; arg_pos++) { // For each argument...
-			st7735_write_data(pgm_read_byte(addr++));  		// Read, send argument
+
+		for(uint8_t i = 0; i < st7735_group_count; i++) {
+			st7735_select(st7735_group[i]);
+			st7735_write_cmd(cmd); 	// Send command
+			for(uint8_t arg_pos = 0; arg_pos < arg_count; arg_pos++) { // For each argument...
+				st7735_write_data(pgm_read_byte(addr + arg_pos));  		// Read, send argument
+			}
 		}
+		addr += arg_count;
 
+		// One wait covers all panels
 		if(has_delay) {
 			uint8_t ms;
 			ms = pgm_read_byte(addr++); // Read post-command delay time (ms)
@@ -92,14 +237,72 @@ void st7735_run_command_list(const uint8_t *addr) {
 	}
 }
 
+static void st7735_reset_group(void) {
+	for(uint8_t i = 0; i < st7735_group_count; i++) {
+		struct st7735_panel *panel = st7735_group[i];
+		*panel->cs_port &= ~panel->cs_mask;
+		*panel->rst_port |= panel->rst_mask;
+	}
+	_delay_ms(500);
+	for(uint8_t i = 0; i < st7735_group_count; i++) {
+		*st7735_group[i]->rst_port &= ~st7735_group[i]->rst_mask;
+	}
+	_delay_ms(500);
+	for(uint8_t i = 0; i < st7735_group_count; i++) {
+		*st7735_group[i]->rst_port |= st7735_group[i]->rst_mask;
+	}
+	_delay_ms(500);
 
-void st7735_init() {
-	// Set rs and rst output
-	DDRB |= (1 << PB0) | (1 << PB1);
+	// Deselected again, the command lists select one panel at a time
+	for(uint8_t i = 0; i < st7735_group_count; i++) {
+		*st7735_group[i]->cs_port |= st7735_group[i]->cs_mask;
+	}
+}
+
+// Offsets and size of the selected panel after its command lists ran
+static void st7735_panel_start(void) {
+	enum ST7735_DISPLAY_TYPE type = st7735_panel_type(st7735_cur);
+	st7735_cur->win_valid = 0;
 
-	st7735_reset();
+	if(type == ST7735_RED_18_BLACKTAB) {
+		// Change MADCTL color filter for black
+		st7735_write_cmd(ST7735_MADCTL);
+		st7735_write_data(0xC0);
+	}
+
+#ifdef ST7735_FIXED
+	// Nothing to set up, only the orientation has to reach the panel
+	st7735_write_cmd(ST7735_MADCTL);
+	st7735_write_data(st7735_madctl());
+#else
+	st7735_cur->row_start = st7735_type_row_start(type);
+	st7735_cur->column_start = st7735_type_column_start(type);
+	if(type != ST7735_BLUE) {
+		st7735_width = st7735_default_width;
+		st7735_height = type == ST7735_RED144_GREENTAB || type == ST7735_RED144_JAYCAR ?
+			st7735_default_height_144 : st7735_default_height_18;
+	}
+#endif
+
+	st7735_clip_reset();
+}
 
-	switch(st7735_type) {
+void st7735_init_panels(struct st7735_panel *const *panels, uint8_t count) {
+	// CS, RS and RST as outputs (DDRx sits right below PORTx), nobody selected
+	for(uint8_t i = 0; i < count; i++) {
+		struct st7735_panel *panel = panels[i];
+		*(panel->cs_port - 1) |= panel->cs_mask;
+		*(panel->rs_port - 1) |= panel->rs_mask;
+		*(panel->rst_port - 1) |= panel->rst_mask;
+		*panel->cs_port |= panel->cs_mask;
+	}
+
+	st7735_group = panels;
+	st7735_group_count = count;
+
+	st7735_reset_group();
+
+	switch(st7735_panel_type(panels[0])) {
 		case ST7735_BLUE:
 			st7735_run_command_list(st7735_blue_init);
 			break;
@@ -108,314 +311,893 @@ void st7735_init() {
 			st7735_run_command_list(st7735_red_init1);
 			st7735_run_command_list(st7735_red_init_green2);
 			st7735_run_command_list(st7735_red_init3);
-			st7735_column_start = st7735_screen_column_start = 2;
-			st7735_row_start = st7735_screen_row_start = 1;
-			st7735_width = st7735_default_width;
-			st7735_height = st7735_default_height_18;
 			break;
 
 		case ST7735_RED_18_REDTAB:
-			st7735_run_command_list(st7735_red_init1);
-			st7735_run_command_list(st7735_red_init_red2);
-			st7735_run_command_list(st7735_red_init3);
-			st7735_width = st7735_default_width;
-			st7735_height = st7735_default_height_18;
-			break;
-
 		case ST7735_RED_18_BLACKTAB:
 			st7735_run_command_list(st7735_red_init1);
 			st7735_run_command_list(st7735_red_init_red2);
 			st7735_run_command_list(st7735_red_init3);
-			// Change MADCTL color filter for black
-			st7735_write_cmd(ST7735_MADCTL);
-			st7735_write_data(0xC0);
-			st7735_width = st7735_default_width;
-			st7735_height = st7735_default_height_18;
 			break;
 
 		case ST7735_RED144_GREENTAB:
-			st7735_height = st7735_default_height_144;
-			st7735_column_start = st7735_screen_column_start = 2;
-			st7735_row_start = st7735_screen_row_start = 3;
-			st7735_run_command_list(st7735_red_init1);
-			st7735_run_command_list(st7735_red_init_green1442);
-			st7735_run_command_list(st7735_red_init3);
-			st7735_width = st7735_default_width;
-			st7735_height = st7735_default_height_144;
-			break;
 		case ST7735_RED144_JAYCAR:
-			st7735_height = st7735_default_height_144;
-			st7735_column_start = st7735_screen_column_start = 0;
-			st7735_row_start = st7735_screen_row_start = 32;
 			st7735_run_command_list(st7735_red_init1);
 			st7735_run_command_list(st7735_red_init_green1442);
 			st7735_run_command_list(st7735_red_init3);
-			st7735_width = st7735_default_width;
-			st7735_height = st7735_default_height_144;
 			break;
 	}
+
+	for(uint8_t i = count; i-- > 0; ) {
+		st7735_select(panels[i]);
+		st7735_panel_start();
+	}
+
+	st7735_group_count = 0;
+}
+
+void st7735_init() {
+	struct st7735_panel *panel = st7735_cur;
+	st7735_init_panels(&panel, 1);
 }
 
 
-enum ST7735_MADCTL_ARGS {
-	MADCTL_MY = 0x80,	// Mirror Y
-	MADCTL_MX = 0x40,	// Mirrror x
-	MADCTL_MV = 0x20,	// Swap XY
-	MADCTL_ML = 0x10,	// Scan address order
-	MADCTL_RGB = 0x00,
-	MADCTL_BGR = 0x08,
-	MADCTL_MH = 0x04 	// Horizontal scan oder
-};
 
 void st7735_set_orientation(enum ST7735_ORIENTATION orientation) {
+#ifdef ST7735_FIXED
+	// Everything is built for ST7735_ORIENTATION, any other one is refused
+	if(orientation != ST7735_ORIENTATION) {
+		return;
+	}
+#endif
+
+	st7735_cur->win_valid = 0;
+
+#ifndef ST7735_FIXED
+	enum ST7735_DISPLAY_TYPE type = st7735_panel_type(st7735_cur);
+	uint8_t row_start = st7735_type_row_start(type);
+	uint8_t column_start = st7735_type_column_start(type);
+
+	st7735_cur->orientation = orientation;
+	st7735_cur->madctl = st7735_orientation_madctl(type, orientation);
+
+	// X and Y swap places in landscape, so do the offsets
+	if(st7735_is_landscape(orientation)) {
+		st7735_cur->row_start = column_start;
+		st7735_cur->column_start = row_start;
+	} else {
+		st7735_cur->row_start = row_start;
+		st7735_cur->column_start = column_start;
+	}
+
+	st7735_width = st7735_panel_width(type, orientation);
+	st7735_height = st7735_panel_height(type, orientation);
+#endif
+
 	st7735_write_cmd(ST7735_MADCTL);
+	st7735_write_data(st7735_madctl());
 
-  	switch (orientation) {
-		case ST7735_PORTRAIT:
-		    if(st7735_type == ST7735_RED_18_BLACKTAB) {
-		    	st7735_write_data(MADCTL_MX | MADCTL_MY | MADCTL_RGB);
-		    } else {
-		    	st7735_write_data(MADCTL_MX | MADCTL_MY | MADCTL_BGR);
-		    }
-
-			st7735_width  = st7735_default_width;
-
-		    if(
-			    st7735_type == ST7735_RED144_GREENTAB ||
-			    st7735_type == ST7735_RED144_JAYCAR
-		    ) {
-			st7735_height = st7735_default_height_144;
-		    } else {
-			st7735_height = st7735_default_height_18;
-		    }
-
-			st7735_column_start = st7735_screen_column_start;
-			st7735_row_start = st7735_screen_row_start;
-			break;
+	st7735_clip_reset();
+}
 
 
-		case ST7735_LANDSCAPE:
-			if(st7735_type == ST7735_RED_18_BLACKTAB) {
-				st7735_write_data(MADCTL_MY | MADCTL_MV | MADCTL_RGB);
-			} else {
-				st7735_write_data(MADCTL_MY | MADCTL_MV | MADCTL_BGR);
-			}
+void st7735_clip_reset(void) {
+	st7735_clip.origin_x = 0;
+	st7735_clip.origin_y = 0;
+	st7735_clip.rect.x0 = 0;
+	st7735_clip.rect.y0 = 0;
+	st7735_clip.rect.x1 = st7735_width - 1;
+	st7735_clip.rect.y1 = st7735_height - 1;
+	st7735_clip_depth = 0;
+}
 
-			if(
-				st7735_type == ST7735_RED144_GREENTAB ||
-				st7735_type == ST7735_RED144_JAYCAR
-			) {
-				st7735_width = st7735_default_height_144;
-			}
-			else {
-				st7735_width = st7735_default_height_18;
-			}
+uint8_t st7735_clip_push(void) {
+	if(st7735_clip_depth == ST7735_CLIP_DEPTH) {
+		return 0;
+	}
 
-			if(st7735_type == ST7735_RED144_JAYCAR) {
-			    st7735_column_start = 32;
-			}
+	st7735_clip_stack[st7735_clip_depth++] = st7735_clip;
+	return 1;
+}
 
-			st7735_height = st7735_default_width;
-			st7735_column_start = st7735_screen_row_start;
-			st7735_row_start = st7735_screen_column_start;
-			break;
+void st7735_clip_pop(void) {
+	if(st7735_clip_depth) {
+		st7735_clip = st7735_clip_stack[--st7735_clip_depth];
+	}
+}
 
-		case ST7735_PORTRAIT_INV:
-			if (st7735_type == ST7735_RED_18_BLACKTAB) {
-				st7735_write_data(MADCTL_RGB);
-			} else {
-				st7735_write_data(MADCTL_BGR);
-			}
+uint8_t st7735_clip_rect(int16_t x, int16_t y, int16_t w, int16_t h, struct st7735_rect *r) {
+	if(w <= 0 || h <= 0) {
+		return 0;
+	}
 
-			st7735_width  = st7735_default_width;
+	x += st7735_clip.origin_x;
+	y += st7735_clip.origin_y;
+	int16_t x1 = x + w - 1;
+	int16_t y1 = y + h - 1;
 
-			if(
-				st7735_type == ST7735_RED144_GREENTAB ||
-				st7735_type == ST7735_RED144_JAYCAR
-			) {
-				st7735_height = st7735_default_height_144;
-			} else {
-				st7735_height = st7735_default_height_18;
-			}
+	if(x < st7735_clip.rect.x0) {
+		x = st7735_clip.rect.x0;
+	}
+	if(y < st7735_clip.rect.y0) {
+		y = st7735_clip.rect.y0;
+	}
+	if(x1 > st7735_clip.rect.x1) {
+		x1 = st7735_clip.rect.x1;
+	}
+	if(y1 > st7735_clip.rect.y1) {
+		y1 = st7735_clip.rect.y1;
+	}
 
-			if(st7735_type == ST7735_RED144_JAYCAR) {
-				st7735_column_start = 0;
-			}
-			st7735_column_start = st7735_screen_column_start;
-			st7735_row_start = st7735_screen_row_start;
+	// Also catches an empty clip rectangle
+	if(x > x1 || y > y1) {
+		return 0;
+	}
 
-			break;
+	r->x0 = x;
+	r->y0 = y;
+	r->x1 = x1;
+	r->y1 = y1;
+	return 1;
+}
 
-		case ST7735_LANDSCAPE_INV:
-			if (st7735_type == ST7735_RED_18_BLACKTAB) {
-				st7735_write_data(MADCTL_MX | MADCTL_MV | MADCTL_RGB);
-			} else {
-				st7735_write_data(MADCTL_MX | MADCTL_MV | MADCTL_BGR);
-			}
+void st7735_clip_intersect(int16_t x, int16_t y, int16_t w, int16_t h) {
+	if(!st7735_clip_rect(x, y, w, h, &st7735_clip.rect)) {
+		st7735_clip.rect.x0 = 1;
+		st7735_clip.rect.x1 = 0;
+	}
+}
 
-			if(
-				st7735_type == ST7735_RED144_GREENTAB ||
-				st7735_type == ST7735_RED144_JAYCAR
-			) {
-				st7735_width = st7735_default_height_144;
-			} else {
-				st7735_width = st7735_default_height_18;
-			}
+void st7735_clip_set(int16_t x, int16_t y, int16_t w, int16_t h) {
+	st7735_clip.rect.x0 = 0;
+	st7735_clip.rect.y0 = 0;
+	st7735_clip.rect.x1 = st7735_width - 1;
+	st7735_clip.rect.y1 = st7735_height - 1;
+	st7735_clip_intersect(x - st7735_clip.origin_x, y - st7735_clip.origin_y, w, h);
+}
 
-			if(st7735_type == ST7735_RED144_JAYCAR) {
-				st7735_column_start = 0;
-			}
+uint8_t st7735_viewport_push(int16_t x, int16_t y, int16_t w, int16_t h) {
+	if(!st7735_clip_push()) {
+		return 0;
+	}
 
-			st7735_height = st7735_default_width;
-			st7735_column_start = st7735_screen_row_start;
-			st7735_row_start = st7735_screen_column_start;
-			break;
+	st7735_clip_intersect(x, y, w, h);
+	st7735_clip.origin_x += x;
+	st7735_clip.origin_y += y;
+	return 1;
+}
+
+// First GRAM line of the rows top .. top + h - 1 (offsets applied); lines
+// run bottom up when mirrored in Y
+static inline uint8_t st7735_gram_line(int16_t top, uint8_t h) {
+	if(st7735_madctl() & MADCTL_MY) {
+		return st7735_gram_height - top - h;
 	}
+	return top;
+}
+
+static inline uint8_t st7735_scroll_tfa(void) {
+	return st7735_gram_line(st7735_cur->scroll_top, st7735_cur->scroll_height);
+}
+
+// Window in GRAM addresses (offsets applied), followed by RAMWR
+static void st7735_write_addr_win(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+	ST7735_PERF_WINDOW();
+
+	if(!st7735_cur->win_valid || x0 != st7735_cur->win_x0 || x1 != st7735_cur->win_x1) {
+		st7735_write_cmd(ST7735_CASET); // Column addr set
+		st7735_write_data(0x00);
+		st7735_write_data(x0);	// XSTART
+		st7735_write_data(0x00);
+		st7735_write_data(x1); // XEND
+		st7735_cur->win_x0 = x0;
+		st7735_cur->win_x1 = x1;
+	}
+
+	if(!st7735_cur->win_valid || y0 != st7735_cur->win_y0 || y1 != st7735_cur->win_y1) {
+		st7735_write_cmd(ST7735_RASET); // Row addr set
+		st7735_write_data(0x00);
+		st7735_write_data(y0); // YSTART
+		st7735_write_data(0x00);
+		st7735_write_data(y1); // YEND
+		st7735_cur->win_y0 = y0;
+		st7735_cur->win_y1 = y1;
+	}
+	st7735_cur->win_valid = 1;
+
+	st7735_write_cmd(ST7735_RAMWR); // write to RAM, restarts at the window origin
 }
 
 void st7735_set_addr_win(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
-	st7735_write_cmd(ST7735_CASET); // Column addr set
-	st7735_write_data(0x00);
-	st7735_write_data(x0 + st7735_column_start);	// XSTART
-	st7735_write_data(0x00);
-	st7735_write_data(x1 + st7735_column_start); // XEND
+	st7735_dirty_add(x0, y0, x1, y1);
 
-	st7735_write_cmd(ST7735_RASET); // Row addr set
-	st7735_write_data(0x00);
-	st7735_write_data(y0 + st7735_row_start); // YSTART
-	st7735_write_data(0x00);
-	st7735_write_data(y1 + st7735_row_start); // YEND
+	st7735_write_addr_win(
+		x0 + st7735_column_start(), y0 + st7735_row_start(),
+		x1 + st7735_column_start(), y1 + st7735_row_start()
+	);
+}
+
+void st7735_write_begin(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+	st7735_set_addr_win(x0, y0, x1, y1);
+
+	st7735_set_rs();
+	st7735_cs_low();
+}
+
+void st7735_write_end(void) {
+	st7735_cs_high();
+}
 
-	st7735_write_cmd(ST7735_RAMWR); // write to RAM
+void st7735_write_continue(void) {
+#ifdef ST7735_ASYNC
+	if(st7735_async_jobs) {
+		st7735_async_flush();
+	}
+#endif
+	st7735_set_rs();
+	st7735_cs_low();
 }
 
 void st7735_draw_pixel(int16_t x, int16_t y, uint16_t color) {
-	if(x < 0 || x >= st7735_width || y < 0 || y >= st7735_height){
+	ST7735_PERF_SCOPE(ST7735_PERF_PIXEL);
+
+	x += st7735_clip.origin_x;
+	y += st7735_clip.origin_y;
+	if(x < st7735_clip.rect.x0 || x > st7735_clip.rect.x1 || y < st7735_clip.rect.y0 || y > st7735_clip.rect.y1) {
 		return;
 	}
 
   	st7735_set_addr_win(x, y, x+1, y+1);
 
   	st7735_set_rs();
-  	spi_unset_cs();
+  	st7735_cs_low();
 
 	st7735_write_color(color);
 
-  	spi_set_cs();
+  	st7735_cs_high();
 }
 
 
-void st7735_fill_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color) {
-	if(x >= st7735_width || y >= st7735_height) {
+void st7735_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+	ST7735_PERF_SCOPE(ST7735_PERF_FILL_RECT);
+
+	struct st7735_rect r;
+	if(!st7735_clip_rect(x, y, w, h, &r)) {
 		return;
 	}
 
-	if((x + w - 1) >= st7735_width) {
-		w = st7735_width  - x;
+	st7735_set_addr_win(r.x0, r.y0, r.x1, r.y1);
+
+	st7735_set_rs();
+	st7735_cs_low();
+
+	st7735_write_color_repeat(color, (uint16_t)(r.x1 - r.x0 + 1) * (r.y1 - r.y0 + 1));
+
+	st7735_cs_high();
+}
+
+
+// RGB565 channels in 1/256 steps, so long gradients do not lose the step
+struct st7735_gradient {
+	uint16_t r, g, b;
+	int16_t dr, dg, db;
+};
+
+// 4x4 Bayer matrix as rounding bias, 8 .. 248 of 256
+static const uint8_t st7735_bayer[4][4] = {
+	{  8, 136,  40, 168},
+	{200,  72, 232, 104},
+	{ 56, 184,  24, 152},
+	{248, 120, 216,  88}
+};
+
+static void st7735_gradient_init(struct st7735_gradient *g, uint16_t from, uint16_t to, int16_t steps) {
+	uint8_t r0 = from >> 11, g0 = (from >> 5) & 0x3F, b0 = from & 0x1F;
+	uint8_t r1 = to >> 11, g1 = (to >> 5) & 0x3F, b1 = to & 0x1F;
+	int16_t div = steps > 1 ? steps - 1 : 1;
+
+	g->r = r0 << 8;
+	g->g = g0 << 8;
+	g->b = b0 << 8;
+	g->dr = ((int16_t)(r1 - r0) << 8) / div;
+	g->dg = ((int16_t)(g1 - g0) << 8) / div;
+	g->db = ((int16_t)(b1 - b0) << 8) / div;
+}
+
+static inline uint16_t st7735_gradient_color(const struct st7735_gradient *g, uint8_t bias) {
+	return (((g->r + bias) >> 8) << 11) | (((g->g + bias) >> 8) << 5) | ((g->b + bias) >> 8);
+}
+
+static inline void st7735_gradient_step(struct st7735_gradient *g) {
+	g->r += g->dr;
+	g->g += g->dg;
+	g->b += g->db;
+}
+
+// Jumps over n steps (lines clipped off at the start)
+static void st7735_gradient_skip(struct st7735_gradient *g, int16_t n) {
+	g->r += g->dr * n;
+	g->g += g->dg * n;
+	g->b += g->db * n;
+}
+
+// The window is open: lines of len pixels each, the color steps once per
+// line. With dither the line only has 4 different colors, made up front.
+static void st7735_gradient_lines(struct st7735_gradient *g, uint8_t lines, uint8_t len, uint8_t dither) {
+	for(uint8_t i = 0; i < lines; i++) {
+		if(dither) {
+			uint16_t colors[4];
+			for(uint8_t k = 0; k < 4; k++) {
+				colors[k] = st7735_gradient_color(g, st7735_bayer[i & 3][k]);
+			}
+			for(uint8_t j = 0; j < len; j++) {
+				st7735_write_color(colors[j & 3]);
+			}
+		} else {
+			st7735_write_color_repeat(st7735_gradient_color(g, 0x80), len);
+		}
+		st7735_gradient_step(g);
 	}
-	if((y + h - 1) >= st7735_height) {
-		h = st7735_height - y;
+}
+
+void st7735_fill_rect_gradient(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t from, uint16_t to, enum ST7735_GRADIENT direction, uint8_t dither) {
+	ST7735_PERF_SCOPE(ST7735_PERF_GRADIENT);
+
+	struct st7735_rect r;
+	if(!st7735_clip_rect(x, y, w, h, &r)) {
+		return;
 	}
 
-	st7735_set_addr_win(x, y, x + w - 1, y + h - 1);
+	// The gradient spans the whole rectangle, clipping only cuts it off
+	struct st7735_gradient g;
+	if(direction == ST7735_GRADIENT_VERTICAL) {
+		st7735_gradient_init(&g, from, to, h);
+		st7735_gradient_skip(&g, r.y0 - (y + st7735_clip.origin_y));
+	} else {
+		st7735_gradient_init(&g, from, to, w);
+		st7735_gradient_skip(&g, r.x0 - (x + st7735_clip.origin_x));
+	}
 
-	st7735_set_rs();
-	spi_unset_cs();
+	x = r.x0;
+	y = r.y0;
+	w = r.x1 - r.x0 + 1;
+	h = r.y1 - r.y0 + 1;
+
+	if(direction == ST7735_GRADIENT_VERTICAL) {
+		st7735_set_addr_win(x, y, x + w - 1, y + h - 1);
+
+		st7735_set_rs();
+		st7735_cs_low();
+		st7735_gradient_lines(&g, h, w, dither);
+		st7735_cs_high();
+	} else if(!(st7735_madctl() & MADCTL_MX) == !(st7735_madctl() & MADCTL_MY)) {
+		// Both mirrors alike: toggling MV transposes the panel, so the
+		// controller fills the window column by column. Rows go to CASET,
+		// columns to RASET, both keep their own offsets.
+		st7735_dirty_add(x, y, x + w - 1, y + h - 1);
+
+		st7735_write_cmd(ST7735_MADCTL);
+		st7735_write_data(st7735_madctl() ^ MADCTL_MV);
+
+		st7735_write_addr_win(
+			y + st7735_row_start(), x + st7735_column_start(),
+			y + h - 1 + st7735_row_start(), x + w - 1 + st7735_column_start()
+		);
+
+		st7735_set_rs();
+		st7735_cs_low();
+		st7735_gradient_lines(&g, w, h, dither);
+		st7735_cs_high();
+
+		st7735_write_cmd(ST7735_MADCTL);
+		st7735_write_data(st7735_madctl());
+	} else {
+		// Transposing would also flip one axis, step the colors along each row
+		st7735_set_addr_win(x, y, x + w - 1, y + h - 1);
+
+		st7735_set_rs();
+		st7735_cs_low();
+		for(uint8_t i = 0; i < h; i++) {
+			struct st7735_gradient row = g;
+			for(uint8_t j = 0; j < w; j++) {
+				st7735_write_color(st7735_gradient_color(&row, dither ? st7735_bayer[i & 3][j & 3] : 0x80));
+				st7735_gradient_step(&row);
+			}
+		}
+		st7735_cs_high();
+	}
+}
 
-	for(uint8_t i = 0; i < h; i++) {
-		for(uint8_t j = 0; j < w; j++) {
+
+// Sends rows x cols pixels of a bitmap, rows stride pixels apart
+static void st7735_write_bitmap(PGM_P bitmap, uint8_t stride, uint8_t cols, uint8_t rows) {
+	uint16_t skip = (stride - cols) * 2;
+
+	for(uint8_t i = 0; i < rows; i++, bitmap += skip) {
+		for(uint8_t j = 0; j < cols; j++) {
+			uint16_t color = pgm_read_word(bitmap);
 			st7735_write_color(color);
+			bitmap += 2;
 		}
 	}
+}
+
+// Limits a source rectangle to the sheet, 0 if nothing is left
+static uint8_t st7735_sheet_rect(PGM_P *sheet, uint8_t *sheet_w, uint8_t sx, uint8_t sy, uint8_t *w, uint8_t *h) {
+	*sheet_w = pgm_read_word(*sheet);
+	uint8_t sheet_h = pgm_read_word(*sheet + 2);
+	*sheet += 4;
 
-	spi_set_cs();
+	if(sx >= *sheet_w || sy >= sheet_h) {
+		return 0;
+	}
+	if(*w > *sheet_w - sx) {
+		*w = *sheet_w - sx;
+	}
+	if(*h > sheet_h - sy) {
+		*h = sheet_h - sy;
+	}
+	return 1;
 }
 
+void st7735_draw_bitmap_rect(int16_t x, int16_t y, PGM_P sheet, uint8_t sx, uint8_t sy, uint8_t w, uint8_t h) {
+	ST7735_PERF_SCOPE(ST7735_PERF_BITMAP);
 
-void st7735_draw_bitmap(uint8_t x, uint8_t y, PGM_P bitmap) {
-	uint8_t w = pgm_read_word(bitmap);
-	bitmap += 2;
-	uint8_t h = pgm_read_word(bitmap);
-	bitmap += 2;
-	uint8_t max_x = x + w - 1;
-	uint8_t max_y = y + h - 1;
+	uint8_t sheet_w;
+	if(!st7735_sheet_rect(&sheet, &sheet_w, sx, sy, &w, &h)) {
+		return;
+	}
 
-	if(x >= st7735_width || y >= st7735_height) {
+	struct st7735_rect r;
+	if(!st7735_clip_rect(x, y, w, h, &r)) {
 		return;
 	}
 
-	if(max_x >= st7735_width) {
-		max_x = st7735_width - 1;
+	// First visible pixel in the sheet, rows follow sheet_w pixels apart
+	uint8_t first_col = sx + r.x0 - (x + st7735_clip.origin_x);
+	uint8_t first_row = sy + r.y0 - (y + st7735_clip.origin_y);
+	sheet += ((uint16_t)first_row * sheet_w + first_col) * 2;
+
+	st7735_write_begin(r.x0, r.y0, r.x1, r.y1);
+	st7735_write_bitmap(sheet, sheet_w, r.x1 - r.x0 + 1, r.y1 - r.y0 + 1);
+	st7735_write_end();
+}
+
+void st7735_draw_bitmap(int16_t x, int16_t y, PGM_P bitmap) {
+	st7735_draw_bitmap_rect(x, y, bitmap, 0, 0, 0xFF, 0xFF);
+}
+
+// GRAM column and row of window address (c, r) under madctl. The mirrors
+// reverse the address counters, MV then sends columns to GRAM rows.
+static void st7735_gram_point(uint8_t madctl, int16_t c, int16_t r, int16_t *col, int16_t *row) {
+	if(madctl & MADCTL_MV) {
+		*row = madctl & MADCTL_MX ? st7735_gram_height - 1 - c : c;
+		*col = madctl & MADCTL_MY ? st7735_gram_width - 1 - r : r;
+	} else {
+		*col = madctl & MADCTL_MX ? st7735_gram_width - 1 - c : c;
+		*row = madctl & MADCTL_MY ? st7735_gram_height - 1 - r : r;
+	}
+}
+
+// The other way round
+static void st7735_gram_address(uint8_t madctl, int16_t col, int16_t row, int16_t *c, int16_t *r) {
+	if(madctl & MADCTL_MV) {
+		*c = madctl & MADCTL_MX ? st7735_gram_height - 1 - row : row;
+		*r = madctl & MADCTL_MY ? st7735_gram_width - 1 - col : col;
+	} else {
+		*c = madctl & MADCTL_MX ? st7735_gram_width - 1 - col : col;
+		*r = madctl & MADCTL_MY ? st7735_gram_height - 1 - row : row;
+	}
+}
+
+// Where source pixel (u, v) of a w x h image drawn at (x, y) ends up, in
+// GRAM coordinates of the current orientation
+struct st7735_blit {
+	int16_t x, y;	// screen, origin applied
+	uint8_t w, h;
+	uint8_t transform;
+};
+
+static void st7735_blit_gram(const struct st7735_blit *b, int16_t u, int16_t v, int16_t *col, int16_t *row) {
+	uint8_t rotate = b->transform & ST7735_BLIT_ROTATE_90;
+	int16_t dx = rotate ? b->h - 1 - v : u;
+	int16_t dy = rotate ? u : v;
+
+	if(b->transform & ST7735_BLIT_FLIP_X) {
+		dx = (rotate ? b->h : b->w) - 1 - dx;
+	}
+	if(b->transform & ST7735_BLIT_FLIP_Y) {
+		dy = (rotate ? b->w : b->h) - 1 - dy;
+	}
+
+	st7735_gram_point(st7735_madctl(),
+		b->x + dx + st7735_column_start(), b->y + dy + st7735_row_start(), col, row);
+}
+
+// Set when write begin transformed changed MADCTL
+static uint8_t st7735_blit_madctl = 0;
+
+uint8_t st7735_write_begin_transformed(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t transform, struct st7735_rect *src) {
+	uint8_t rotate = transform & ST7735_BLIT_ROTATE_90;
+	uint8_t dw = rotate ? h : w;
+	uint8_t dh = rotate ? w : h;
+
+	struct st7735_rect r;
+	if(!st7735_clip_rect(x, y, dw, dh, &r)) {
+		return 0;
+	}
+
+	struct st7735_blit b = { x + st7735_clip.origin_x, y + st7735_clip.origin_y, w, h, transform };
+
+	// Visible part of the destination back to source coordinates
+	uint8_t x0 = r.x0 - b.x, x1 = r.x1 - b.x;
+	uint8_t y0 = r.y0 - b.y, y1 = r.y1 - b.y;
+	if(transform & ST7735_BLIT_FLIP_X) {
+		uint8_t t = dw - 1 - x0;
+		x0 = dw - 1 - x1;
+		x1 = t;
+	}
+	if(transform & ST7735_BLIT_FLIP_Y) {
+		uint8_t t = dh - 1 - y0;
+		y0 = dh - 1 - y1;
+		y1 = t;
 	}
+	if(rotate) {
+		src->x0 = y0;
+		src->x1 = y1;
+		src->y0 = h - 1 - x1;
+		src->y1 = h - 1 - x0;
+	} else {
+		src->x0 = x0;
+		src->x1 = x1;
+		src->y0 = y0;
+		src->y1 = y1;
+	}
+
+	// GRAM steps of one source column and one source row
+	int16_t col, row, u_col, u_row, v_col, v_row;
+	st7735_blit_gram(&b, src->x0, src->y0, &col, &row);
+	st7735_blit_gram(&b, src->x0 + 1, src->y0, &u_col, &u_row);
+	st7735_blit_gram(&b, src->x0, src->y0 + 1, &v_col, &v_row);
+
+	// Scan order that walks the GRAM the same way: source rows along
+	// GRAM columns or (MV) GRAM rows, each address counter mirrored where
+	// it has to run backwards
+	uint8_t madctl = st7735_madctl() & ~(MADCTL_MX | MADCTL_MY | MADCTL_MV);
+	if(u_col != col) {
+		madctl |= (u_col < col ? MADCTL_MX : 0) | (v_row < row ? MADCTL_MY : 0);
+	} else {
+		madctl |= MADCTL_MV | (u_row < row ? MADCTL_MX : 0) | (v_col < col ? MADCTL_MY : 0);
+	}
+
+	// Window corners are the first and the last pixel sent
+	int16_t c0, r0, c1, r1;
+	st7735_gram_address(madctl, col, row, &c0, &r0);
+	st7735_blit_gram(&b, src->x1, src->y1, &col, &row);
+	st7735_gram_address(madctl, col, row, &c1, &r1);
+
+	st7735_dirty_add(r.x0, r.y0, r.x1, r.y1);
 
-	if(max_y >= st7735_height) {
-		max_y = st7735_height - 1;
+	st7735_blit_madctl = madctl != st7735_madctl();
+	if(st7735_blit_madctl) {
+		st7735_write_cmd(ST7735_MADCTL);
+		st7735_write_data(madctl);
 	}
 
-	st7735_set_addr_win(x, y, max_x, max_y);
+	st7735_write_addr_win(c0, r0, c1, r1);
 
 	st7735_set_rs();
-	spi_unset_cs();
+	st7735_cs_low();
+	return 1;
+}
 
-	for(uint8_t i = 0; i < h; i++) {
-		for(uint8_t j = 0; j < w; j++) {
-			if((x + j) >= st7735_width || (y + i) >= st7735_height) {
-				bitmap += 2;
-				continue;
-			}
-			uint16_t color = pgm_read_word(bitmap);
-			st7735_write_color(color);
-			bitmap += 2;
+void st7735_write_end_transformed(void) {
+	st7735_cs_high();
+
+	if(st7735_blit_madctl) {
+		st7735_write_cmd(ST7735_MADCTL);
+		st7735_write_data(st7735_madctl());
+		st7735_blit_madctl = 0;
+	}
+}
+
+void st7735_draw_bitmap_rect_transformed(int16_t x, int16_t y, PGM_P sheet, uint8_t sx, uint8_t sy,
+                                         uint8_t w, uint8_t h, uint8_t transform) {
+	ST7735_PERF_SCOPE(ST7735_PERF_BITMAP);
+
+	uint8_t sheet_w;
+	if(!st7735_sheet_rect(&sheet, &sheet_w, sx, sy, &w, &h)) {
+		return;
+	}
+
+	struct st7735_rect src;
+	if(!st7735_write_begin_transformed(x, y, w, h, transform, &src)) {
+		return;
+	}
+
+	sheet += ((uint16_t)(sy + src.y0) * sheet_w + sx + src.x0) * 2;
+	st7735_write_bitmap(sheet, sheet_w, src.x1 - src.x0 + 1, src.y1 - src.y0 + 1);
+
+	st7735_write_end_transformed();
+}
+
+// Each pixel tests a constant mask, no shifting or counting
+#define ST7735_MONO_PIXEL(mask) st7735_write_color((bits & (mask)) ? color_set : color_unset)
+
+static void st7735_write_mono8_msb(uint8_t bits, uint16_t color_set, uint16_t color_unset) {
+	ST7735_MONO_PIXEL(0x80);
+	ST7735_MONO_PIXEL(0x40);
+	ST7735_MONO_PIXEL(0x20);
+	ST7735_MONO_PIXEL(0x10);
+	ST7735_MONO_PIXEL(0x08);
+	ST7735_MONO_PIXEL(0x04);
+	ST7735_MONO_PIXEL(0x02);
+	ST7735_MONO_PIXEL(0x01);
+}
+
+static void st7735_write_mono8_lsb(uint8_t bits, uint16_t color_set, uint16_t color_unset) {
+	ST7735_MONO_PIXEL(0x01);
+	ST7735_MONO_PIXEL(0x02);
+	ST7735_MONO_PIXEL(0x04);
+	ST7735_MONO_PIXEL(0x08);
+	ST7735_MONO_PIXEL(0x10);
+	ST7735_MONO_PIXEL(0x20);
+	ST7735_MONO_PIXEL(0x40);
+	ST7735_MONO_PIXEL(0x80);
+}
+
+// n pixels of one byte, from bit first on (counted in bit order)
+static void st7735_write_mono_bits(uint8_t bits, uint8_t first, uint8_t n, enum ST7735_BIT_ORDER order,
+                                   uint16_t color_set, uint16_t color_unset) {
+	if(order == ST7735_LSB_FIRST) {
+		bits >>= first;
+		while(n--) {
+			st7735_write_color((bits & 0x01) ? color_set : color_unset);
+			bits >>= 1;
+		}
+	}
+	else {
+		bits <<= first;
+		while(n--) {
+			st7735_write_color((bits & 0x80) ? color_set : color_unset);
+			bits <<= 1;
+		}
+	}
+}
+
+void st7735_write_mono(PGM_P src, uint16_t skip, uint16_t count, enum ST7735_BIT_ORDER order,
+                       uint16_t color_set, uint16_t color_unset) {
+	src += skip / 8;
+
+	uint8_t first = skip % 8;
+	if(first) {
+		uint8_t n = 8 - first;
+		if(n > count) {
+			n = count;
+		}
+		st7735_write_mono_bits(pgm_read_byte(src++), first, n, order, color_set, color_unset);
+		count -= n;
+	}
+
+	if(order == ST7735_LSB_FIRST) {
+		for(; count >= 8; count -= 8) {
+			st7735_write_mono8_lsb(pgm_read_byte(src++), color_set, color_unset);
+		}
+	}
+	else {
+		for(; count >= 8; count -= 8) {
+			st7735_write_mono8_msb(pgm_read_byte(src++), color_set, color_unset);
+		}
+	}
+
+	if(count) {
+		st7735_write_mono_bits(pgm_read_byte(src), 0, count, order, color_set, color_unset);
+	}
+}
+
+void st7735_draw_mono_bitmap(int16_t x, int16_t y, PGM_P bitmap, uint16_t color_set, uint16_t color_unset) {
+	ST7735_PERF_SCOPE(ST7735_PERF_MONO_BITMAP);
+
+	uint8_t w = pgm_read_byte(bitmap++);
+	uint8_t h = pgm_read_byte(bitmap++);
+
+	struct st7735_rect r;
+	if(!st7735_clip_rect(x, y, w, h, &r)) {
+		return;
+	}
+
+	uint8_t first_col = r.x0 - (x + st7735_clip.origin_x);
+	uint8_t first_row = r.y0 - (y + st7735_clip.origin_y);
+	uint8_t cols = r.x1 - r.x0 + 1;
+	uint8_t rows = r.y1 - r.y0 + 1;
+
+	st7735_write_begin(r.x0, r.y0, r.x1, r.y1);
+
+	// Bits run LSB first through the whole bitmap, rows are not padded,
+	// so full width rows are one run
+	uint16_t bit_pos = (uint16_t)first_row * w + first_col;
+	if(cols == w) {
+		st7735_write_mono(bitmap, bit_pos, (uint16_t)rows * w, ST7735_LSB_FIRST, color_set, color_unset);
+	}
+	else {
+		for(uint8_t i = 0; i < rows; i++, bit_pos += w) {
+			st7735_write_mono(bitmap, bit_pos, cols, ST7735_LSB_FIRST, color_set, color_unset);
 		}
 	}
 
-	spi_set_cs();
+	st7735_write_end();
 }
 
-void st7735_draw_mono_bitmap(uint8_t x, uint8_t y, PGM_P bitmap, uint16_t color_set, uint16_t color_unset) {
+void st7735_draw_mono_bitmap_transformed(int16_t x, int16_t y, PGM_P bitmap, uint16_t color_set, uint16_t color_unset,
+                                         uint8_t transform) {
+	ST7735_PERF_SCOPE(ST7735_PERF_MONO_BITMAP);
+
 	uint8_t w = pgm_read_byte(bitmap++);
 	uint8_t h = pgm_read_byte(bitmap++);
-	uint8_t max_x = x + w - 1;
-	uint8_t max_y = y + h - 1;
 
-	if(x >= st7735_width || y >= st7735_height) {
+	struct st7735_rect src;
+	if(!st7735_write_begin_transformed(x, y, w, h, transform, &src)) {
 		return;
 	}
 
-	if(max_x >= st7735_width) {
-		max_x = st7735_width - 1;
+	uint8_t cols = src.x1 - src.x0 + 1;
+	uint16_t bit_pos = (uint16_t)src.y0 * w + src.x0;
+	for(uint8_t i = src.y0; i <= src.y1; i++, bit_pos += w) {
+		st7735_write_mono(bitmap, bit_pos, cols, ST7735_LSB_FIRST, color_set, color_unset);
+	}
+
+	st7735_write_end_transformed();
+}
+
+
+uint8_t st7735_scroll_define(int16_t y, uint8_t h) {
+	// Rows are GRAM columns when X and Y are swapped
+	if(st7735_madctl() & MADCTL_MV) {
+		return 0;
 	}
 
-	if(max_y >= st7735_height) {
-		max_y = st7735_height - 1;
+	int16_t top = y + st7735_row_start();
+	if(h == 0 || top < 0 || top + h > st7735_gram_height) {
+		return 0;
 	}
 
-	st7735_set_addr_win(x, y, max_x, max_y);
+	st7735_cur->scroll_top = top;
+	st7735_cur->scroll_height = h;
 
-	st7735_set_rs();
-	spi_unset_cs();
-
-	uint16_t bit_pos = 0;
-	uint8_t byte = 0;
-	for(uint8_t i = 0; i < h; i++) {
-		for(uint8_t j = 0; j < w; j++) {
-			if(bit_pos % 8 == 0) {
-				byte = pgm_read_byte(bitmap++);
-			}
+	// Scroll areas are in GRAM lines, which run bottom up when mirrored in Y
+	uint8_t tfa = st7735_scroll_tfa();
+	st7735_write_cmd(ST7735_VSCRDEF);
+	st7735_write_data(0x00);
+	st7735_write_data(tfa); // Top fixed area
+	st7735_write_data(0x00);
+	st7735_write_data(h); // Scroll area
+	st7735_write_data(0x00);
+	st7735_write_data(st7735_gram_height - tfa - h); // Bottom fixed area
 
-			if((x + j) >= st7735_width || (y + i) >= st7735_height) {
-				bit_pos++;
-				continue;
-			}
-			if(byte & (1 << (bit_pos % 8))) {
-				st7735_write_color(color_set);
-			}
-			else {
-				st7735_write_color(color_unset);
-			}
-			bit_pos++;
+	st7735_scroll_set(0);
+	return 1;
+}
+
+void st7735_scroll_set(uint8_t offset) {
+	uint8_t tfa = st7735_scroll_tfa();
+	uint8_t h = st7735_cur->scroll_height;
+	// No scroll area defined yet
+	if(!h) {
+		return;
+	}
+	offset %= h;
+
+	st7735_write_cmd(ST7735_VSCSAD);
+	st7735_write_data(0x00);
+	if(st7735_madctl() & MADCTL_MY) {
+		st7735_write_data(tfa + (h - offset) % h);
+	} else {
+		st7735_write_data(tfa + offset);
+	}
+}
+
+void st7735_scroll_reset(void) {
+	st7735_write_cmd(ST7735_NORON);
+}
+
+
+uint8_t st7735_page_begin(uint8_t y, uint8_t h) {
+	uint8_t below = st7735_gram_height - st7735_row_start() - st7735_height;
+	uint8_t above = st7735_row_start();
+
+	if(y + h == st7735_height && h <= below) {
+		// Green tab: spare rows follow the visible ones
+		st7735_cur->page_shift = h;
+		if(!st7735_scroll_define(y, 2 * h)) {
+			return 0;
+		}
+	} else if(y == 0 && h <= above) {
+		// Jaycar: spare rows precede the visible ones
+		st7735_cur->page_shift = -h;
+		if(!st7735_scroll_define(-(int16_t)h, 2 * h)) {
+			return 0;
+		}
+	} else {
+		return 0;
+	}
+
+	st7735_cur->page_height = h;
+	st7735_cur->page_shown = 0;
+	return 1;
+}
+
+void st7735_page_draw_begin(void) {
+	// The hidden copy is the one not shown; shift rows to reach it
+	if(!st7735_cur->page_shown) {
+		st7735_cur->row_start += st7735_cur->page_shift;
+		st7735_cur->win_valid = 0;
+	}
+}
+
+void st7735_page_flip(void) {
+	if(!st7735_cur->page_shown) {
+		st7735_cur->row_start -= st7735_cur->page_shift;
+		st7735_cur->win_valid = 0;
+	}
+
+	st7735_cur->page_shown = !st7735_cur->page_shown;
+	st7735_scroll_set(st7735_cur->page_shown ? st7735_cur->page_height : 0);
+}
+
+void st7735_page_end(void) {
+	st7735_scroll_reset();
+	st7735_cur->page_shown = 0;
+}
+
+
+void st7735_display_on(uint8_t on) {
+	st7735_write_cmd(on ? ST7735_DISPON : ST7735_DISPOFF);
+}
+
+void st7735_invert_display(uint8_t on) {
+	st7735_write_cmd(on ? ST7735_INVON : ST7735_INVOFF);
+}
+
+uint8_t st7735_set_partial_area(uint8_t y, uint8_t h) {
+	if((st7735_madctl() & MADCTL_MV) || h == 0 || y + h > st7735_height) {
+		return 0;
+	}
+
+	uint8_t start = st7735_gram_line(y + st7735_row_start(), h);
+	st7735_write_cmd(ST7735_PTLAR);
+	st7735_write_data(0x00);
+	st7735_write_data(start); // PSL
+	st7735_write_data(0x00);
+	st7735_write_data(start + h - 1); // PEL
+
+	return 1;
+}
+
+void st7735_set_power_mode(enum ST7735_POWER_MODE mode) {
+	uint8_t partial = mode == ST7735_POWER_PARTIAL || mode == ST7735_POWER_PARTIAL_IDLE;
+	uint8_t idle = mode == ST7735_POWER_IDLE || mode == ST7735_POWER_PARTIAL_IDLE;
+
+	if(idle) {
+		// FRMCTR2 only applies in idle mode: slowest line period and porches
+		st7735_write_cmd(ST7735_FRMCTR2);
+		st7735_write_data(0x0F);
+		st7735_write_data(0x3F);
+		st7735_write_data(0x3F);
+	}
+
+	if(partial) {
+		// FRMCTR3 only applies in partial mode, same for dot and column inversion
+		st7735_write_cmd(ST7735_FRMCTR3);
+		for(uint8_t i = 0; i < 2; i++) {
+			st7735_write_data(0x0F);
+			st7735_write_data(0x3F);
+			st7735_write_data(0x3F);
 		}
+		st7735_write_cmd(ST7735_PTLON);
+	} else {
+		// Also leaves scroll mode
+		st7735_write_cmd(ST7735_NORON);
 	}
 
-	spi_set_cs();
+	st7735_write_cmd(idle ? ST7735_IDMON : ST7735_IDMOFF);
 }
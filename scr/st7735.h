@@ -5,6 +5,9 @@
 
 #include<stdint.h>
 
+#include "spi.h"
+#include "st7735_perf.h"
+
 static const uint8_t st7735_default_width = 128;
 // for 1.44" display
 static const uint8_t st7735_default_height_144 = 128;
@@ -20,7 +23,24 @@ enum ST7735_DISPLAY_TYPE {
 	ST7735_RED144_JAYCAR
 };
 
-static const enum ST7735_DISPLAY_TYPE st7735_type = ST7735_RED144_GREENTAB;
+// Optional compile time configuration, e.g. in platformio.ini:
+//   build_flags = -DST7735_TYPE=ST7735_RED144_GREENTAB -DST7735_ORIENTATION=ST7735_PORTRAIT
+// ST7735_TYPE makes every panel that type: the other types' branches and
+// init tables are left out. Adding ST7735_ORIENTATION fixes the
+// orientation too, so offsets, MADCTL and the panel size become
+// constants (st7735_width/height included) and st7735_set_orientation
+// only sends the fixed MADCTL again; it ignores any other orientation.
+#if defined(ST7735_TYPE) && defined(ST7735_ORIENTATION)
+#define ST7735_FIXED
+#endif
+
+// Type of the default panel
+#ifdef ST7735_TYPE
+#define ST7735_DEFAULT_TYPE ST7735_TYPE
+#else
+#define ST7735_DEFAULT_TYPE ST7735_RED144_GREENTAB
+#endif
+static const enum ST7735_DISPLAY_TYPE st7735_type = ST7735_DEFAULT_TYPE;
 
 
 // ST7735 commands
@@ -45,6 +65,10 @@ enum ST7735_COMMANDS {
 	ST7735_RAMRD = 0x2E,
 
 	ST7735_PTLAR = 0x30,
+	ST7735_VSCRDEF = 0x33,
+	ST7735_VSCSAD = 0x37,
+	ST7735_IDMOFF = 0x38,
+	ST7735_IDMON = 0x39,
 	ST7735_COLMOD = 0x3A,
 	ST7735_MADCTL = 0x36,
 
@@ -90,27 +114,263 @@ enum ST7735_ORIENTATION {
 	ST7735_PORTRAIT_INV
 };
 
+// Panel size, folds to a constant for constant arguments
+static inline uint8_t st7735_panel_width(enum ST7735_DISPLAY_TYPE type, enum ST7735_ORIENTATION orientation) {
+	uint8_t is_144 = type == ST7735_RED144_GREENTAB || type == ST7735_RED144_JAYCAR;
+	if(orientation == ST7735_LANDSCAPE || orientation == ST7735_LANDSCAPE_INV) {
+		return is_144 ? st7735_default_height_144 : st7735_default_height_18;
+	}
+	return st7735_default_width;
+}
+
+static inline uint8_t st7735_panel_height(enum ST7735_DISPLAY_TYPE type, enum ST7735_ORIENTATION orientation) {
+	uint8_t is_144 = type == ST7735_RED144_GREENTAB || type == ST7735_RED144_JAYCAR;
+	if(orientation == ST7735_LANDSCAPE || orientation == ST7735_LANDSCAPE_INV) {
+		return st7735_default_width;
+	}
+	return is_144 ? st7735_default_height_144 : st7735_default_height_18;
+}
+
+// Current panel size for the active orientation
+#ifdef ST7735_FIXED
+#define st7735_width st7735_panel_width(ST7735_TYPE, ST7735_ORIENTATION)
+#define st7735_height st7735_panel_height(ST7735_TYPE, ST7735_ORIENTATION)
+#else
+extern uint8_t st7735_width;
+extern uint8_t st7735_height;
+#endif
+
+struct st7735_rect {
+	uint8_t x0, y0;	// inclusive corners
+	uint8_t x1, y1;
+};
+
+// The primitives take coordinates relative to the viewport origin and only
+// draw inside the clip rectangle (screen coordinates, empty if x0 > x1).
+// Raw streaming (st7735_write_begin) and the modules built on it work in
+// screen coordinates and ignore both.
+struct st7735_clip {
+	int16_t origin_x, origin_y;
+	struct st7735_rect rect;
+};
+
+extern struct st7735_clip st7735_clip;
+
+// Saved states, push/pop pairs may nest this deep
+#define ST7735_CLIP_DEPTH 4
+
+// Areas drawn on since the last clear, kept by st7735_dirty.c. When
+// full, a new area is merged into the rectangle that grows the least.
+#define ST7735_DIRTY_RECTS 4
+
+struct st7735_dirty {
+	struct st7735_rect rects[ST7735_DIRTY_RECTS];
+	uint8_t count;
+};
+
+extern struct st7735_dirty st7735_dirty;
+
+// Whole screen, origin in the top left corner, stack emptied. Done by
+// init and set orientation.
+void st7735_clip_reset(void);
+// Saves the current state, returns 0 if the stack is full
+uint8_t st7735_clip_push(void);
+void st7735_clip_pop(void);
+// Narrows the clip rectangle to x, y, w, h (viewport coordinates)
+void st7735_clip_intersect(int16_t x, int16_t y, int16_t w, int16_t h);
+// Replaces the clip rectangle by x, y, w, h in screen coordinates
+void st7735_clip_set(int16_t x, int16_t y, int16_t w, int16_t h);
+// Push, intersect with x, y, w, h and move the origin to x, y
+uint8_t st7735_viewport_push(int16_t x, int16_t y, int16_t w, int16_t h);
+
+// Visible screen part of x, y, w, h (viewport coordinates) in *r,
+// returns 0 if nothing is left to draw
+uint8_t st7735_clip_rect(int16_t x, int16_t y, int16_t w, int16_t h, struct st7735_rect *r);
+
+// One panel on the shared SPI bus (MOSI/SCK), with its own CS, RS and
+// RST lines. The driver works on the selected panel; st7735_width,
+// st7735_height, st7735_clip and st7735_dirty always belong to it and are
+// saved into the struct when another panel gets selected. The clip stack
+// is shared, select with the stack empty.
+struct st7735_panel {
+	volatile uint8_t *cs_port, *rs_port, *rst_port;	// &PORTx
+	uint8_t cs_mask, rs_mask, rst_mask;
+	enum ST7735_DISPLAY_TYPE type;	// ST7735_TYPE when that is defined
+	enum ST7735_ORIENTATION orientation;
+	uint8_t madctl;	// last value written by set orientation
+
+	// GRAM offsets for the current orientation. With ST7735_FIXED the
+	// offsets are constants and row_start only holds the page shift.
+	uint8_t row_start, column_start;
+	uint8_t width, height;
+	struct st7735_clip clip;
+	struct st7735_dirty dirty;
+
+	// Last address window sent (offsets applied). Consecutive runs on
+	// the same row or column then skip the repeated RASET/CASET.
+	uint8_t win_x0, win_x1, win_y0, win_y1;
+	uint8_t win_valid;
+
+	int16_t scroll_top;	// GRAM row (offsets applied)
+	uint8_t scroll_height;
+	int8_t page_shift;	// rows from the band to its hidden copy
+	uint8_t page_height;
+	uint8_t page_shown;	// hidden copy currently visible in the band
+};
+
+// Wired as before: CS on PB2, RS on PB0, RST on PB1, ST7735_DEFAULT_TYPE.
+// Selected from the start, so single panel code needs none of this.
+extern struct st7735_panel st7735_panel_default;
+
+void st7735_panel_setup(struct st7735_panel *panel, enum ST7735_DISPLAY_TYPE type,
+	volatile uint8_t *cs_port, uint8_t cs_pin,
+	volatile uint8_t *rs_port, uint8_t rs_pin,
+	volatile uint8_t *rst_port, uint8_t rst_pin);
+
+void st7735_select(struct st7735_panel *panel);
+struct st7735_panel *st7735_selected(void);
+
+// Initializes the selected panel
 void st7735_init(void);
+// Initializes panels of one type together: the reset and the command
+// delays are waited for once, not once per panel. Selects panels[0].
+void st7735_init_panels(struct st7735_panel *const *panels, uint8_t count);
 
 void st7735_set_orientation(enum ST7735_ORIENTATION orientation);
 
 void st7735_draw_pixel(int16_t x, int16_t y, uint16_t color);
-void st7735_fill_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color);
+void st7735_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+enum ST7735_GRADIENT {
+	ST7735_GRADIENT_VERTICAL,	// from at the top row, to at the bottom row
+	ST7735_GRADIENT_HORIZONTAL	// from at the left column, to at the right column
+};
+
+// Fills the rectangle with a gradient through one window, optionally with
+// 4x4 ordered dithering to hide the RGB565 banding
+void st7735_fill_rect_gradient(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t from, uint16_t to, enum ST7735_GRADIENT direction, uint8_t dither);
 
-static inline void st7735_draw_fast_vline(uint8_t x, uint8_t y, uint8_t h, uint16_t color) {
+static inline void st7735_draw_fast_vline(int16_t x, int16_t y, int16_t h, uint16_t color) {
 	st7735_fill_rect(x, y, 1, h, color);
 }
 
-static inline void st7735_draw_fast_hline(uint8_t x, uint8_t y, uint8_t w, uint16_t color) {
+static inline void st7735_draw_fast_hline(int16_t x, int16_t y, int16_t w, uint16_t color) {
 	st7735_fill_rect(x, y, w, 1, color);
 }
 
+// 8 bit channels to RGB565, the macro folds to a constant for table
+// initializers. Blends, fades and ramps are in st7735_color.h.
+#define ST7735_RGB(r, g, b) \
+	((uint16_t)((((uint16_t)(r) & 0xF8) << 8) | (((uint16_t)(g) & 0xFC) << 3) | ((uint8_t)(b) >> 3)))
+
 static inline uint16_t st7735_color(uint8_t r, uint8_t g, uint8_t b) {
-  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+  return ST7735_RGB(r, g, b);
+}
+
+// Raw pixel streaming: open a window, push (x1-x0+1)*(y1-y0+1) colors
+// row by row, then close it again.
+void st7735_write_begin(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+void st7735_write_end(void);
+// Picks up a stream closed by write end where it stopped, as long as no
+// command went to this panel since (other panels do not matter)
+void st7735_write_continue(void);
+
+static inline void st7735_write_color(uint16_t color) {
+	ST7735_PERF_PIXELS(1);
+	spi_write(color >> 8);
+	spi_write(color);
+}
+
+// The same color count times
+static inline void st7735_write_color_repeat(uint16_t color, uint16_t count) {
+	ST7735_PERF_PIXELS(count);
+	spi_write_repeat16(color, count);
 }
 
-void st7735_draw_bitmap(uint8_t x, uint8_t y, PGM_P bitmap);
+enum ST7735_BIT_ORDER {
+	ST7735_MSB_FIRST,	// GFX glyphs, stamps
+	ST7735_LSB_FIRST	// mono bitmaps, mono tiles
+};
+
+// Sends count pixels of 1 bpp PROGMEM data to the open window, starting
+// skip bits into src. Whole source bytes go through an unrolled 8 pixel
+// kernel, only partial bytes at the ends are taken bit by bit, so pass
+// as long a run as possible (e.g. all rows when none is cut by the clip).
+void st7735_write_mono(PGM_P src, uint16_t skip, uint16_t count, enum ST7735_BIT_ORDER order,
+                       uint16_t color_set, uint16_t color_unset);
+
+// Hardware vertical scroll of screen rows [y, y + h). The area may reach
+// into the GRAM rows hidden above (y < 0) or below the panel. Portrait
+// orientations only, returns 0 if the area is not possible.
+uint8_t st7735_scroll_define(int16_t y, uint8_t h);
+// Show row y + offset (wrapping inside the area) at the top of the area,
+// nothing before st7735_scroll_define succeeded
+void st7735_scroll_set(uint8_t offset);
+void st7735_scroll_reset(void);
+
+// Double buffered band of rows [y, y + h) using the hidden GRAM rows: the
+// band has to touch the bottom edge (green tab, up to 31 rows) or the top
+// edge (Jaycar, up to 32 rows). Returns 0 if that is not possible.
+//
+//   st7735_page_draw_begin();
+//   ... draw the band in screen coordinates ...
+//   st7735_page_flip();	// shows it all at once
+//
+// Only draw the band between draw begin and flip while the page is active.
+uint8_t st7735_page_begin(uint8_t y, uint8_t h);
+void st7735_page_draw_begin(void);
+void st7735_page_flip(void);
+void st7735_page_end(void);
+
+// Panel output on/off (GRAM keeps its contents) and color inversion
+void st7735_display_on(uint8_t on);
+void st7735_invert_display(uint8_t on);
+
+enum ST7735_POWER_MODE {
+	ST7735_POWER_NORMAL,		// whole panel, 65k colors
+	ST7735_POWER_PARTIAL,		// only the partial area is driven
+	ST7735_POWER_IDLE,			// 8 colors (MSB of each channel), slow frame rate
+	ST7735_POWER_PARTIAL_IDLE	// both
+};
+
+// Rows [y, y + h) kept on in the partial modes. Portrait orientations only,
+// returns 0 if the area is not possible.
+uint8_t st7735_set_partial_area(uint8_t y, uint8_t h);
+void st7735_set_power_mode(enum ST7735_POWER_MODE mode);
+
+// Blit transforms, done by the panel's scan order (MADCTL) so they cost
+// nothing extra. Can be combined; the quarter turn comes first, then
+// the flips in screen space.
+enum ST7735_BLIT {
+	ST7735_BLIT_NONE = 0x00,
+	ST7735_BLIT_FLIP_X = 0x01,		// mirrored left to right
+	ST7735_BLIT_FLIP_Y = 0x02,		// mirrored top to bottom
+	ST7735_BLIT_ROTATE_90 = 0x04,	// quarter turn clockwise
+	ST7735_BLIT_ROTATE_180 = ST7735_BLIT_FLIP_X | ST7735_BLIT_FLIP_Y,
+	ST7735_BLIT_ROTATE_270 = ST7735_BLIT_ROTATE_90 | ST7735_BLIT_FLIP_X | ST7735_BLIT_FLIP_Y
+};
+
+// Pixel streaming for a w x h source image drawn at (x, y) with a
+// transform. Returns 0 if nothing is visible, otherwise send the source
+// pixels of *src (source coordinates) row by row as usual, then call
+// write end transformed, which restores the orientation.
+uint8_t st7735_write_begin_transformed(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t transform, struct st7735_rect *src);
+void st7735_write_end_transformed(void);
+
+void st7735_draw_bitmap(int16_t x, int16_t y, PGM_P bitmap);
+
+// Draws the w x h part at (sx, sy) of a bitmap, e.g. one frame or icon
+// of a sprite sheet. Only the visible rows and columns are read.
+//
+//   // 16x16 frames side by side
+//   st7735_draw_bitmap_rect(x, y, walk_sheet, frame * 16, 0, 16, 16);
+void st7735_draw_bitmap_rect(int16_t x, int16_t y, PGM_P sheet, uint8_t sx, uint8_t sy, uint8_t w, uint8_t h);
+// Same with a transform (enum ST7735_BLIT), e.g. a sprite facing left
+void st7735_draw_bitmap_rect_transformed(int16_t x, int16_t y, PGM_P sheet, uint8_t sx, uint8_t sy,
+                                         uint8_t w, uint8_t h, uint8_t transform);
 
-void st7735_draw_mono_bitmap(uint8_t x, uint8_t y, PGM_P bitmap, uint16_t color_set, uint16_t color_unset);
+void st7735_draw_mono_bitmap(int16_t x, int16_t y, PGM_P bitmap, uint16_t color_set, uint16_t color_unset);
+void st7735_draw_mono_bitmap_transformed(int16_t x, int16_t y, PGM_P bitmap, uint16_t color_set, uint16_t color_unset,
+                                         uint8_t transform);
 
 #endif
@@ -0,0 +1,271 @@
+#include "st7735_async.h"
+
+#ifdef ST7735_ASYNC
+
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "spi.h"
+
+// At these dividers a byte takes fewer cycles than the interrupt sending
+// it, the queue is slower than drawing right away
+#if SPI_DIVIDER < 16
+#warning "ST7735_ASYNC does not pay off with SPI_DIVIDER below 16, measure with ST7735_ASYNC_BENCH"
+#endif
+
+struct st7735_async_job {
+	struct st7735_panel *panel;
+	struct st7735_rect win;	// screen coordinates, clipped
+	PGM_P src;				// first pixel, NULL for a fill
+	uint16_t color;
+	uint16_t skip;			// bytes from the end of one row to the next
+};
+
+static struct st7735_async_job st7735_async_queue[ST7735_ASYNC_JOBS];
+static uint8_t st7735_async_head = 0;	// next job to start
+uint8_t st7735_async_jobs = 0;			// queued, running included
+
+// The running job has its window open (CS low) until pending closes it
+static struct st7735_panel *st7735_async_open = NULL;
+// Set while pending talks to the panel itself
+static uint8_t st7735_async_busy = 0;
+
+// Interrupt side. Only the interrupt touches these while streaming, the
+// ports stay with the main program (they are read-modify-write).
+static volatile uint8_t st7735_async_streaming = 0;
+static PGM_P st7735_async_src;
+static uint16_t st7735_async_word;
+static uint16_t st7735_async_left;	// pixels not started yet
+static uint16_t st7735_async_skip;
+static uint8_t st7735_async_cols;
+static uint8_t st7735_async_col;
+static uint8_t st7735_async_low;	// low byte of the pixel goes next
+
+static inline void st7735_async_next(void) {
+	if(st7735_async_low) {
+		SPDR = st7735_async_word;
+		st7735_async_low = 0;
+		return;
+	}
+
+	if(!st7735_async_left) {
+		SPCR &= ~(1 << SPIE);
+		st7735_async_streaming = 0;
+		return;
+	}
+
+	if(st7735_async_src) {
+		st7735_async_word = pgm_read_word(st7735_async_src);
+		st7735_async_src += 2;
+		if(!--st7735_async_col) {
+			st7735_async_col = st7735_async_cols;
+			st7735_async_src += st7735_async_skip;
+		}
+	}
+
+	SPDR = st7735_async_word >> 8;
+	st7735_async_low = 1;
+	st7735_async_left--;
+}
+
+ISR(SPI_STC_vect) {
+	st7735_async_next();
+}
+
+static void st7735_async_start(const struct st7735_async_job *job) {
+	struct st7735_panel *selected = st7735_selected();
+	st7735_select(job->panel);
+	st7735_write_begin(job->win.x0, job->win.y0, job->win.x1, job->win.y1);
+	st7735_select(selected);
+	st7735_async_open = job->panel;
+
+	uint8_t cols = job->win.x1 - job->win.x0 + 1;
+	st7735_async_src = job->src;
+	st7735_async_word = job->color;
+	st7735_async_left = (uint16_t)cols * (job->win.y1 - job->win.y0 + 1);
+	st7735_async_skip = job->skip;
+	st7735_async_cols = cols;
+	st7735_async_col = cols;
+	st7735_async_low = 0;
+	st7735_async_streaming = 1;
+
+	ST7735_PERF_PIXELS(st7735_async_left);
+	SPI_COUNT_BYTES(2 * (uint32_t)st7735_async_left);
+
+	// The first byte goes out from here. SPIF is still set from the last
+	// command byte; reading SPSR and then writing SPDR clears it, so the
+	// first interrupt comes when this byte is done.
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		(void)SPSR;
+		SPCR |= (1 << SPIE);
+		st7735_async_next();
+	}
+}
+
+uint8_t st7735_async_pending(void) {
+	if(st7735_async_streaming || st7735_async_busy) {
+		return st7735_async_jobs;
+	}
+
+	st7735_async_busy = 1;
+
+	if(st7735_async_open) {
+		struct st7735_panel *selected = st7735_selected();
+		st7735_select(st7735_async_open);
+		st7735_write_end();
+		st7735_select(selected);
+		st7735_async_open = NULL;
+		st7735_async_jobs--;
+	}
+
+	if(st7735_async_jobs) {
+		st7735_async_start(&st7735_async_queue[st7735_async_head]);
+		st7735_async_head = (st7735_async_head + 1) % ST7735_ASYNC_JOBS;
+	}
+
+	st7735_async_busy = 0;
+	return st7735_async_jobs;
+}
+
+void st7735_async_wait(void) {
+	while(st7735_async_pending())
+		;
+}
+
+void st7735_async_flush(void) {
+	// Commands sent by pending itself go through
+	if(!st7735_async_busy) {
+		st7735_async_wait();
+	}
+}
+
+// Slot for a new job, waits while the queue is full
+static struct st7735_async_job *st7735_async_slot(void) {
+	while(st7735_async_jobs == ST7735_ASYNC_JOBS) {
+		st7735_async_pending();
+	}
+	return &st7735_async_queue[(st7735_async_head + st7735_async_jobs - (st7735_async_open != NULL)) % ST7735_ASYNC_JOBS];
+}
+
+static void st7735_async_push(void) {
+	st7735_async_jobs++;
+	st7735_async_pending();
+}
+
+void st7735_async_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+	struct st7735_rect r;
+	if(!st7735_clip_rect(x, y, w, h, &r)) {
+		return;
+	}
+
+	struct st7735_async_job *job = st7735_async_slot();
+	job->panel = st7735_selected();
+	job->win = r;
+	job->src = NULL;
+	job->color = color;
+	st7735_async_push();
+}
+
+void st7735_async_draw_bitmap_rect(int16_t x, int16_t y, PGM_P sheet, uint8_t sx, uint8_t sy, uint8_t w, uint8_t h) {
+	uint8_t sheet_w = pgm_read_word(sheet);
+	uint8_t sheet_h = pgm_read_word(sheet + 2);
+	sheet += 4;
+
+	// Source rectangle limited to the sheet
+	if(sx >= sheet_w || sy >= sheet_h) {
+		return;
+	}
+	if(w > sheet_w - sx) {
+		w = sheet_w - sx;
+	}
+	if(h > sheet_h - sy) {
+		h = sheet_h - sy;
+	}
+
+	struct st7735_rect r;
+	if(!st7735_clip_rect(x, y, w, h, &r)) {
+		return;
+	}
+
+	uint8_t first_col = sx + r.x0 - (x + st7735_clip.origin_x);
+	uint8_t first_row = sy + r.y0 - (y + st7735_clip.origin_y);
+
+	struct st7735_async_job *job = st7735_async_slot();
+	job->panel = st7735_selected();
+	job->win = r;
+	job->src = sheet + ((uint16_t)first_row * sheet_w + first_col) * 2;
+	job->skip = (sheet_w - (r.x1 - r.x0 + 1)) * 2;
+	st7735_async_push();
+}
+
+#ifdef ST7735_ASYNC_BENCH
+
+#include "timebase.h"
+
+// One full screen fill per queue slot, all queued at once
+#define ST7735_ASYNC_BENCH_FILLS ST7735_ASYNC_JOBS
+
+static volatile uint8_t st7735_async_bench_sink;
+
+// Counts loop passes until the queue drained (ms 0) or for ms
+// milliseconds; both ways a pass costs the same
+static uint32_t st7735_async_bench_work(uint16_t ms) {
+	uint32_t work = 0;
+	uint16_t start = timebase_now();
+
+	for(;;) {
+		uint8_t pending = st7735_async_pending();
+		uint16_t elapsed = timebase_now() - start;
+		if(ms ? elapsed >= ms : !pending) {
+			return work;
+		}
+		st7735_async_bench_sink++;
+		work++;
+	}
+}
+
+void st7735_async_bench(struct st7735_async_bench_result *result) {
+	uint16_t start = timebase_now();
+	for(uint8_t i = 0; i < ST7735_ASYNC_BENCH_FILLS; i++) {
+		st7735_fill_rect(0, 0, st7735_width, st7735_height, i & 1 ? ST7735_COLOR_WHITE : ST7735_COLOR_BLACK);
+	}
+	result->sync_ms = timebase_now() - start;
+
+	start = timebase_now();
+	for(uint8_t i = 0; i < ST7735_ASYNC_BENCH_FILLS; i++) {
+		st7735_async_fill_rect(0, 0, st7735_width, st7735_height, i & 1 ? ST7735_COLOR_WHITE : ST7735_COLOR_BLACK);
+	}
+	uint32_t work = st7735_async_bench_work(0);
+	result->async_ms = timebase_now() - start;
+
+	// The same loop with nothing queued, for as long
+	uint32_t idle = st7735_async_bench_work(result->async_ms);
+	result->cpu_free = idle ? work * 100 / idle : 0;
+}
+
+#endif
+
+#else
+
+#ifdef ST7735_ASYNC_BENCH
+#error "ST7735_ASYNC_BENCH needs ST7735_ASYNC"
+#endif
+
+void st7735_async_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+	st7735_fill_rect(x, y, w, h, color);
+}
+
+void st7735_async_draw_bitmap_rect(int16_t x, int16_t y, PGM_P sheet, uint8_t sx, uint8_t sy, uint8_t w, uint8_t h) {
+	st7735_draw_bitmap_rect(x, y, sheet, sx, sy, w, h);
+}
+
+uint8_t st7735_async_pending(void) {
+	return 0;
+}
+
+void st7735_async_wait(void) {
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef _ST7735_ASYNC_H_
+#define _ST7735_ASYNC_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "st7735.h"
+
+// Fills and blits that stream their pixels from the SPI interrupt, so
+// the CPU can do other work meanwhile. Build with -DST7735_ASYNC, without
+// it the calls below draw right away (synchronous fallback).
+//
+//   st7735_async_fill_rect(0, 0, 128, 64, ST7735_COLOR_BLACK);
+//   ... compute the next frame ...
+//   st7735_async_wait();
+//
+// Jobs keep their order and run on the panel selected when they were
+// queued, clipped with the clip rectangle of that moment. The window of a
+// job is set up from st7735_async_pending() (or any other driver call)
+// after the previous one drained, so call it now and then while working.
+// Every other driver call waits for the queue to drain first.
+//
+// The interrupt costs about 40 cycles per byte: it only pays when the
+// SPI clock is slow enough to leave the CPU time between bytes
+// (SPI_BYTE_CYCLES well above that, see st7735_async_bench). With the
+// default SPI_DIVIDER of 4 (32 cycles per byte) it is a net loss, the
+// build warns below 16, and main.c draws synchronously.
+//
+// Estimated from the instruction cycles of the interrupt, about 45 per
+// byte with the entry and exit (not measured, run st7735_async_bench on
+// the board for real numbers). One 128x128 fill, 32768 bytes at 1 MHz:
+//
+//   SPI_DIVIDER  cycles/byte  fill sync  fill async  CPU free
+//             4           32     1.05 s     ~1.5 s        0 %
+//            16          128     4.2 s      ~4.2 s      ~65 %
+//            64          512    16.8 s     ~16.8 s      ~91 %
+
+#define ST7735_ASYNC_JOBS 4
+
+void st7735_async_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+// Part of a PROGMEM bitmap, as st7735_draw_bitmap_rect
+void st7735_async_draw_bitmap_rect(int16_t x, int16_t y, PGM_P sheet, uint8_t sx, uint8_t sy, uint8_t w, uint8_t h);
+
+// Starts the next job if the previous one is done. Returns the jobs not
+// finished yet, 0 when everything reached the panel.
+uint8_t st7735_async_pending(void);
+void st7735_async_wait(void);
+
+#ifdef ST7735_ASYNC
+// Jobs queued or running, checked by the driver before every command
+extern uint8_t st7735_async_jobs;
+void st7735_async_flush(void);
+#endif
+
+#ifdef ST7735_ASYNC_BENCH
+// Full screen fills, synchronous against queued, and how much of the
+// CPU was left meanwhile. Build with -DST7735_ASYNC -DST7735_ASYNC_BENCH.
+struct st7735_async_bench_result {
+	uint16_t sync_ms;
+	uint16_t async_ms;
+	uint8_t cpu_free;	// percent of the async time spent outside the interrupt
+};
+
+void st7735_async_bench(struct st7735_async_bench_result *result);
+#endif
+
+#endif
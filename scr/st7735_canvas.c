@@ -0,0 +1,58 @@
+#include "st7735_canvas.h"
+
+void st7735_canvas_select(const struct st7735_canvas *canvas, uint8_t i) {
+	const struct st7735_canvas_panel *entry = &canvas->panels[i];
+
+	// The panel keeps its clip rectangle, only the origin changes
+	st7735_select(entry->panel);
+	st7735_clip.origin_x = -entry->x;
+	st7735_clip.origin_y = -entry->y;
+}
+
+void st7735_canvas_fill_rect(const struct st7735_canvas *canvas, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+	struct st7735_panel *selected = st7735_selected();
+	struct st7735_rect area[ST7735_CANVAS_PANELS];
+	uint8_t rows_left[ST7735_CANVAS_PANELS];
+	uint8_t busy = 0;
+
+	// Window commands for every panel first
+	for(uint8_t i = 0; i < canvas->count; i++) {
+		st7735_select(canvas->panels[i].panel);
+		struct st7735_clip saved = st7735_clip;
+		st7735_canvas_select(canvas, i);
+
+		rows_left[i] = 0;
+		if(st7735_clip_rect(x, y, w, h, &area[i])) {
+			st7735_write_begin(area[i].x0, area[i].y0, area[i].x1, area[i].y1);
+			st7735_write_end();
+			rows_left[i] = area[i].y1 - area[i].y0 + 1;
+			busy++;
+		}
+		st7735_clip = saved;
+	}
+
+	// Then only pixel data, the panels keep their write position while
+	// deselected
+	while(busy) {
+		for(uint8_t i = 0; i < canvas->count; i++) {
+			if(!rows_left[i]) {
+				continue;
+			}
+
+			uint8_t rows = rows_left[i] < ST7735_CANVAS_BAND ? rows_left[i] : ST7735_CANVAS_BAND;
+			uint16_t pixels = (uint16_t)rows * (area[i].x1 - area[i].x0 + 1);
+
+			st7735_select(canvas->panels[i].panel);
+			st7735_write_continue();
+			st7735_write_color_repeat(color, pixels);
+			st7735_write_end();
+
+			rows_left[i] -= rows;
+			if(!rows_left[i]) {
+				busy--;
+			}
+		}
+	}
+
+	st7735_select(selected);
+}
@@ -0,0 +1,49 @@
+#ifndef _ST7735_CANVAS_H_
+#define _ST7735_CANVAS_H_
+
+#include <stdint.h>
+
+#include "st7735.h"
+
+// Several panels put together into one drawing area, e.g. two 128x128
+// panels side by side for a 256x128 canvas:
+//
+//   static const struct st7735_canvas_panel wall_panels[] = {
+//   	{ &st7735_panel_default, 0, 0 },
+//   	{ &right_panel, 128, 0 }
+//   };
+//   static const struct st7735_canvas wall = { wall_panels, 2 };
+//
+//   for(uint8_t i = 0; i < wall.count; i++) {
+//   	st7735_canvas_select(&wall, i);
+//   	st7735_draw_circle(128, 64, 50, ST7735_COLOR_RED);	// canvas coordinates
+//   }
+//
+// The primitives reject what falls outside the selected panel up front.
+
+#define ST7735_CANVAS_PANELS 4
+
+// Rows streamed to one panel before the next one gets its turn
+#define ST7735_CANVAS_BAND 8
+
+struct st7735_canvas_panel {
+	struct st7735_panel *panel;
+	int16_t x, y;	// top left corner on the canvas
+};
+
+struct st7735_canvas {
+	const struct st7735_canvas_panel *panels;
+	uint8_t count;	// up to ST7735_CANVAS_PANELS
+};
+
+// Selects panel i with the origin moved so the primitives take canvas
+// coordinates. Its clip rectangle and the clip stack stay as they are.
+void st7735_canvas_select(const struct st7735_canvas *canvas, uint8_t i);
+
+// Fills a rectangle in canvas coordinates. The windows of all panels it
+// touches are set up first, then the pixels go out band by band, taking
+// turns between the panels, so they fill up together. The clip of each
+// panel and the selected panel are left as they were.
+void st7735_canvas_fill_rect(const struct st7735_canvas *canvas, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+#endif
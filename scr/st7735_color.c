@@ -0,0 +1,42 @@
+#include "st7735_color.h"
+
+// Spreads 0bRRRRRGGGGGGBBBBB to 0b00000GGGGGG00000_RRRRR000000BBBBB so every
+// channel has 5 free bits above it: both products of the blend fit.
+static inline uint32_t st7735_color_spread(uint16_t c) {
+	return (c | ((uint32_t)c << 16)) & 0x07E0F81FUL;
+}
+
+uint16_t st7735_color_blend(uint16_t fg, uint16_t bg, uint8_t alpha) {
+	uint8_t a = (alpha + 4) >> 3;	// 0 .. 32
+
+	uint32_t x = st7735_color_spread(fg) * a + st7735_color_spread(bg) * (32 - a);
+	x = (x >> 5) & 0x07E0F81FUL;
+
+	return (uint16_t)x | (uint16_t)(x >> 16);
+}
+
+uint16_t st7735_color_hsv(uint16_t h, uint8_t s, uint8_t v) {
+	uint8_t sector = h >> 8;
+	uint8_t f = h;
+
+	// 8x8 bit products only, each channel ends up in 0 .. v. Unsigned,
+	// 255 * 255 does not fit the 16 bit int.
+	uint8_t p = ((uint16_t)v * (uint8_t)~s) >> 8;
+	uint8_t q = ((uint16_t)v * (uint8_t)~(((uint16_t)s * f) >> 8)) >> 8;
+	uint8_t t = ((uint16_t)v * (uint8_t)~(((uint16_t)s * (uint8_t)~f) >> 8)) >> 8;
+
+	switch(sector) {
+	case 0:
+		return st7735_color(v, t, p);
+	case 1:
+		return st7735_color(q, v, p);
+	case 2:
+		return st7735_color(p, v, t);
+	case 3:
+		return st7735_color(p, q, v);
+	case 4:
+		return st7735_color(t, p, v);
+	default:
+		return st7735_color(v, p, q);
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef _ST7735_COLOR_H_
+#define _ST7735_COLOR_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "st7735.h"
+
+// RGB565 helpers that never carry one channel into the next.
+
+// Average of two colors: drop each channel's LSB before the shift so
+// nothing spills over, add the common bits back.
+static inline uint16_t st7735_color_blend50(uint16_t a, uint16_t b) {
+	return (((a ^ b) & 0xF7DE) >> 1) + (a & b);
+}
+
+// fg over bg, alpha 0 (bg) .. 255 (fg), 32 levels
+uint16_t st7735_color_blend(uint16_t fg, uint16_t bg, uint8_t alpha);
+
+// a at t = 0 to b at t = 255
+static inline uint16_t st7735_color_lerp(uint16_t a, uint16_t b, uint8_t t) {
+	return st7735_color_blend(b, a, t);
+}
+
+// Hue 0 .. ST7735_HUE_MAX - 1 (red, yellow, green, cyan, blue, magenta,
+// 256 steps each), saturation and value 0 .. 255
+#define ST7735_HUE_MAX 1536
+uint16_t st7735_color_hsv(uint16_t h, uint8_t s, uint8_t v);
+
+// Gamma corrected ramps, computed by the compiler into PROGMEM tables:
+//
+//   static const uint16_t PROGMEM fade[16] = ST7735_RAMP16(0x000000, 0xFF8000);
+//   color = st7735_color_ramp(fade, i);
+//
+// Colors are 0xRRGGBB. The ramp follows t^2.2 (approximated by a
+// polynomial so it stays a constant expression), which gives even looking
+// steps instead of rushing through the dark end.
+#define ST7735_GAMMA_SHAPE(t) ((t) * (t) * (0.8 + 0.2 * (t)))
+#define ST7735_RAMP_CHANNEL(from, to, shift, t) \
+	((uint8_t)((((from) >> (shift)) & 0xFF) + \
+	((double)(((to) >> (shift)) & 0xFF) - (((from) >> (shift)) & 0xFF)) * ST7735_GAMMA_SHAPE(t) + 0.5))
+#define ST7735_RAMP_COLOR(from, to, t) ST7735_RGB( \
+	ST7735_RAMP_CHANNEL(from, to, 16, t), \
+	ST7735_RAMP_CHANNEL(from, to, 8, t), \
+	ST7735_RAMP_CHANNEL(from, to, 0, t))
+#define ST7735_RAMP16(from, to) { \
+	ST7735_RAMP_COLOR(from, to, 0 / 15.0), ST7735_RAMP_COLOR(from, to, 1 / 15.0), \
+	ST7735_RAMP_COLOR(from, to, 2 / 15.0), ST7735_RAMP_COLOR(from, to, 3 / 15.0), \
+	ST7735_RAMP_COLOR(from, to, 4 / 15.0), ST7735_RAMP_COLOR(from, to, 5 / 15.0), \
+	ST7735_RAMP_COLOR(from, to, 6 / 15.0), ST7735_RAMP_COLOR(from, to, 7 / 15.0), \
+	ST7735_RAMP_COLOR(from, to, 8 / 15.0), ST7735_RAMP_COLOR(from, to, 9 / 15.0), \
+	ST7735_RAMP_COLOR(from, to, 10 / 15.0), ST7735_RAMP_COLOR(from, to, 11 / 15.0), \
+	ST7735_RAMP_COLOR(from, to, 12 / 15.0), ST7735_RAMP_COLOR(from, to, 13 / 15.0), \
+	ST7735_RAMP_COLOR(from, to, 14 / 15.0), ST7735_RAMP_COLOR(from, to, 15 / 15.0) }
+
+static inline uint16_t st7735_color_ramp(const uint16_t *ramp, uint8_t i) {
+	return pgm_read_word(&ramp[i]);
+}
+
+#endif
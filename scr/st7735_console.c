@@ -0,0 +1,142 @@
+#include "st7735_console.h"
+
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#include "st7735.h"
+#include "tom_thumb.h"
+
+#define CONSOLE_BASELINE 5	// TomThumb glyphs reach 5 rows above the baseline
+
+static char st7735_console_text[ST7735_CONSOLE_ROWS][ST7735_CONSOLE_COLS];
+
+static uint8_t st7735_console_y;
+static uint16_t st7735_console_fg, st7735_console_bg;
+static uint8_t st7735_console_hw_scroll;
+
+// Buffer row shown at the top; buffer row n always lives in GRAM rows
+// y + 6n, scrolling only moves where the panel starts showing them
+static uint8_t st7735_console_top;
+static uint8_t st7735_console_row;	// cursor, in screen lines
+static uint8_t st7735_console_col;
+
+
+// Sends one cell through a single 4x6 window
+static void st7735_console_draw_cell(uint8_t slot, uint8_t col) {
+	char c = st7735_console_text[slot][col];
+	uint8_t x = col * ST7735_CONSOLE_CELL_W;
+	uint8_t y = st7735_console_y + slot * ST7735_CONSOLE_CELL_H;
+
+	// TomThumb glyphs are one byte per row, MSB first, x offset 0
+	const uint8_t *bitmap = NULL;
+	uint8_t first_row = 0, height = 0;
+	if(c > ' ' && c <= 0x7E) {
+		const GFXglyph *glyph = &TomThumbGlyphs[c - ' '];
+		bitmap = TomThumbBitmaps + pgm_read_word(&glyph->bitmapOffset);
+		height = pgm_read_byte(&glyph->height);
+		first_row = CONSOLE_BASELINE + (int8_t)pgm_read_byte(&glyph->yOffset);
+	}
+
+	st7735_write_begin(x, y, x + ST7735_CONSOLE_CELL_W - 1, y + ST7735_CONSOLE_CELL_H - 1);
+
+	for(uint8_t row = 0; row < ST7735_CONSOLE_CELL_H; row++) {
+		if(row >= first_row && row < first_row + height) {
+			st7735_write_mono((PGM_P)bitmap + row - first_row, 0, ST7735_CONSOLE_CELL_W, ST7735_MSB_FIRST,
+			                  st7735_console_fg, st7735_console_bg);
+		}
+		else {
+			st7735_write_color_repeat(st7735_console_bg, ST7735_CONSOLE_CELL_W);
+		}
+	}
+
+	st7735_write_end();
+}
+
+static void st7735_console_clear_slot(uint8_t slot) {
+	memset(st7735_console_text[slot], ' ', ST7735_CONSOLE_COLS);
+
+	// Screen coordinates like the cells, clip and viewport do not apply
+	uint8_t y = st7735_console_y + slot * ST7735_CONSOLE_CELL_H;
+	st7735_write_begin(0, y, ST7735_CONSOLE_COLS * ST7735_CONSOLE_CELL_W - 1, y + ST7735_CONSOLE_CELL_H - 1);
+	st7735_write_color_repeat(st7735_console_bg, ST7735_CONSOLE_COLS * ST7735_CONSOLE_CELL_W * ST7735_CONSOLE_CELL_H);
+	st7735_write_end();
+}
+
+void st7735_console_redraw(void) {
+	for(uint8_t slot = 0; slot < ST7735_CONSOLE_ROWS; slot++) {
+		for(uint8_t col = 0; col < ST7735_CONSOLE_COLS; col++) {
+			st7735_console_draw_cell(slot, col);
+		}
+	}
+}
+
+void st7735_console_clear(void) {
+	for(uint8_t slot = 0; slot < ST7735_CONSOLE_ROWS; slot++) {
+		st7735_console_clear_slot(slot);
+	}
+
+	st7735_console_top = 0;
+	st7735_console_row = 0;
+	st7735_console_col = 0;
+	if(st7735_console_hw_scroll) {
+		st7735_scroll_set(0);
+	}
+}
+
+void st7735_console_init(uint8_t y, uint16_t fg, uint16_t bg) {
+	st7735_console_y = y;
+	st7735_console_fg = fg;
+	st7735_console_bg = bg;
+	st7735_console_hw_scroll = st7735_scroll_define(y, ST7735_CONSOLE_ROWS * ST7735_CONSOLE_CELL_H);
+
+	st7735_console_clear();
+}
+
+
+static void st7735_console_newline(void) {
+	st7735_console_col = 0;
+
+	if(st7735_console_row < ST7735_CONSOLE_ROWS - 1) {
+		st7735_console_row++;
+		return;
+	}
+
+	if(st7735_console_hw_scroll) {
+		// The top line becomes the new bottom line: blank it, move the start
+		uint8_t slot = st7735_console_top;
+		st7735_console_clear_slot(slot);
+		st7735_console_top = (slot + 1) % ST7735_CONSOLE_ROWS;
+		st7735_scroll_set(st7735_console_top * ST7735_CONSOLE_CELL_H);
+	} else {
+		memmove(st7735_console_text[0], st7735_console_text[1],
+		        (ST7735_CONSOLE_ROWS - 1) * ST7735_CONSOLE_COLS);
+		memset(st7735_console_text[ST7735_CONSOLE_ROWS - 1], ' ', ST7735_CONSOLE_COLS);
+		st7735_console_redraw();
+	}
+}
+
+void st7735_console_putc(char c) {
+	if(c == '\n') {
+		st7735_console_newline();
+		return;
+	}
+	if(c == '\r') {
+		st7735_console_col = 0;
+		return;
+	}
+
+	if(st7735_console_col == ST7735_CONSOLE_COLS) {
+		st7735_console_newline();
+	}
+
+	uint8_t slot = (st7735_console_top + st7735_console_row) % ST7735_CONSOLE_ROWS;
+	st7735_console_text[slot][st7735_console_col] = c;
+	st7735_console_draw_cell(slot, st7735_console_col);
+	st7735_console_col++;
+}
+
+void st7735_console_puts(const char *text) {
+	while(*text) {
+		st7735_console_putc(*text++);
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef _ST7735_CONSOLE_H_
+#define _ST7735_CONSOLE_H_
+
+#include <stdint.h>
+
+// Text console in the TomThumb font, one 4x6 cell per character.
+// The text buffer takes COLS * ROWS bytes of SRAM.
+#define ST7735_CONSOLE_COLS 32
+#define ST7735_CONSOLE_ROWS 8
+#define ST7735_CONSOLE_CELL_W 4
+#define ST7735_CONSOLE_CELL_H 6
+
+// Places the console at screen rows y .. y + ROWS * 6 - 1 and clears it.
+// New lines scroll with the hardware scroll when the orientation allows
+// it (portrait), otherwise the whole console is repainted.
+void st7735_console_init(uint8_t y, uint16_t fg, uint16_t bg);
+
+// Handles '\n' (new line) and '\r' (start of line), long lines wrap
+void st7735_console_putc(char c);
+void st7735_console_puts(const char *text);
+void st7735_console_clear(void);
+
+// Paints every cell again, e.g. after the area was drawn over
+void st7735_console_redraw(void);
+
+#endif
@@ -0,0 +1,135 @@
+#include "st7735_dirty.h"
+
+#include "st7735.h"
+
+struct st7735_dirty st7735_dirty;
+static uint8_t st7735_dirty_paused = 0;
+
+static inline uint8_t st7735_rect_touches(const struct st7735_rect *a, const struct st7735_rect *b) {
+	// Overlapping or directly adjacent
+	return a->x0 <= b->x1 + 1 && b->x0 <= a->x1 + 1 &&
+	       a->y0 <= b->y1 + 1 && b->y0 <= a->y1 + 1;
+}
+
+static inline void st7735_rect_union(struct st7735_rect *a, const struct st7735_rect *b) {
+	if(b->x0 < a->x0) a->x0 = b->x0;
+	if(b->y0 < a->y0) a->y0 = b->y0;
+	if(b->x1 > a->x1) a->x1 = b->x1;
+	if(b->y1 > a->y1) a->y1 = b->y1;
+}
+
+static inline uint16_t st7735_rect_area(const struct st7735_rect *a) {
+	return (uint16_t)(a->x1 - a->x0 + 1) * (a->y1 - a->y0 + 1);
+}
+
+// Rect pos grew: fold in every other rect it now touches
+static void st7735_dirty_collapse(uint8_t pos) {
+	uint8_t i = 0;
+	while(i < st7735_dirty.count) {
+		if(i != pos && st7735_rect_touches(&st7735_dirty.rects[pos], &st7735_dirty.rects[i])) {
+			st7735_rect_union(&st7735_dirty.rects[pos], &st7735_dirty.rects[i]);
+
+			st7735_dirty.count--;
+			st7735_dirty.rects[i] = st7735_dirty.rects[st7735_dirty.count];
+			if(pos == st7735_dirty.count) {
+				pos = i;
+			}
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+}
+
+
+void st7735_dirty_add(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+	if(st7735_dirty_paused) {
+		return;
+	}
+
+	if(x1 >= st7735_width) {
+		x1 = st7735_width - 1;
+	}
+	if(y1 >= st7735_height) {
+		y1 = st7735_height - 1;
+	}
+
+	struct st7735_rect area = { x0, y0, x1, y1 };
+
+	// Most windows (pixels, runs) land inside an existing rect
+	for(uint8_t i = 0; i < st7735_dirty.count; i++) {
+		struct st7735_rect *r = &st7735_dirty.rects[i];
+		if(x0 >= r->x0 && x1 <= r->x1 && y0 >= r->y0 && y1 <= r->y1) {
+			return;
+		}
+	}
+
+	for(uint8_t i = 0; i < st7735_dirty.count; i++) {
+		if(st7735_rect_touches(&st7735_dirty.rects[i], &area)) {
+			st7735_rect_union(&st7735_dirty.rects[i], &area);
+			st7735_dirty_collapse(i);
+			return;
+		}
+	}
+
+	if(st7735_dirty.count < ST7735_DIRTY_RECTS) {
+		st7735_dirty.rects[st7735_dirty.count++] = area;
+		return;
+	}
+
+	// Full: merge into the rect whose area grows the least
+	uint8_t best = 0;
+	uint16_t best_growth = UINT16_MAX;
+	for(uint8_t i = 0; i < st7735_dirty.count; i++) {
+		struct st7735_rect merged = st7735_dirty.rects[i];
+		st7735_rect_union(&merged, &area);
+		uint16_t growth = st7735_rect_area(&merged) - st7735_rect_area(&st7735_dirty.rects[i]);
+		if(growth < best_growth) {
+			best_growth = growth;
+			best = i;
+		}
+	}
+	st7735_rect_union(&st7735_dirty.rects[best], &area);
+	st7735_dirty_collapse(best);
+}
+
+void st7735_dirty_reset(void) {
+	st7735_dirty.count = 0;
+}
+
+// Areas are in screen coordinates, the clip rectangle still applies
+static void st7735_dirty_fill(const struct st7735_rect *r, uint16_t color) {
+	st7735_fill_rect(r->x0 - st7735_clip.origin_x, r->y0 - st7735_clip.origin_y,
+		r->x1 - r->x0 + 1, r->y1 - r->y0 + 1, color);
+}
+
+void st7735_clear_dirty(uint16_t color) {
+	// The clearing fills must not mark themselves dirty again
+	st7735_dirty_paused = 1;
+
+	for(uint8_t i = 0; i < st7735_dirty.count; i++) {
+		struct st7735_rect *r = &st7735_dirty.rects[i];
+		st7735_dirty_fill(r, color);
+	}
+
+	st7735_dirty.count = 0;
+	st7735_dirty_paused = 0;
+}
+
+void st7735_clear_dirty_in(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint16_t color) {
+	st7735_dirty_paused = 1;
+
+	for(uint8_t i = 0; i < st7735_dirty.count; i++) {
+		struct st7735_rect area = st7735_dirty.rects[i];
+		if(area.x0 < x0) area.x0 = x0;
+		if(area.y0 < y0) area.y0 = y0;
+		if(area.x1 > x1) area.x1 = x1;
+		if(area.y1 > y1) area.y1 = y1;
+
+		if(area.x0 <= area.x1 && area.y0 <= area.y1) {
+			st7735_dirty_fill(&area, color);
+		}
+	}
+
+	st7735_dirty_paused = 0;
+}
@@ -0,0 +1,24 @@
+#ifndef _ST7735_DIRTY_H_
+#define _ST7735_DIRTY_H_
+
+#include <stdint.h>
+
+#include "st7735.h"
+
+// Every panel has its own list (st7735_dirty, see st7735.h), these work
+// on the selected one.
+
+// Called by the driver for every address window it opens
+void st7735_dirty_add(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+
+// Forget everything drawn so far (e.g. after a full screen clear)
+void st7735_dirty_reset(void);
+
+// Fill only the areas drawn on since the last clear/reset with color
+void st7735_clear_dirty(uint16_t color);
+
+// Fill the drawn on parts of x0..x1, y0..y1 (inclusive) with color, the
+// areas stay recorded until a reset or full clear
+void st7735_clear_dirty_in(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint16_t color);
+
+#endif
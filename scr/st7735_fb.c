@@ -0,0 +1,287 @@
+#include "st7735_fb.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#include "st7735.h"
+
+#if ST7735_FB_BPP != 1 && ST7735_FB_BPP != 2
+#error "ST7735_FB_BPP must be 1 or 2"
+#endif
+
+#define ST7735_FB_PER_BYTE (8 / ST7735_FB_BPP)
+#define ST7735_FB_STRIDE (ST7735_FB_W / ST7735_FB_PER_BYTE)
+#define ST7735_FB_MASK (ST7735_FB_COLORS - 1)
+
+// Pixels are packed MSB first
+static uint8_t st7735_fb[ST7735_FB_H][ST7735_FB_STRIDE];
+
+// Changed columns per row, clean rows have x0 > x1
+static uint8_t st7735_fb_dirty_x0[ST7735_FB_H];
+static uint8_t st7735_fb_dirty_x1[ST7735_FB_H];
+
+static uint16_t st7735_fb_palette[ST7735_FB_COLORS] = {
+	ST7735_COLOR_BLACK,
+	ST7735_COLOR_WHITE,
+#if ST7735_FB_BPP == 2
+	ST7735_COLOR_RED,
+	ST7735_COLOR_BLUE
+#endif
+};
+
+static enum ST7735_FB_OP st7735_fb_op = ST7735_FB_SET;
+
+
+static inline void st7735_fb_mark(uint8_t x0, uint8_t x1, uint8_t y) {
+	if(x0 < st7735_fb_dirty_x0[y]) st7735_fb_dirty_x0[y] = x0;
+	if(x1 > st7735_fb_dirty_x1[y]) st7735_fb_dirty_x1[y] = x1;
+}
+
+void st7735_fb_invalidate(void) {
+	for(uint8_t y = 0; y < ST7735_FB_H; y++) {
+		st7735_fb_dirty_x0[y] = 0;
+		st7735_fb_dirty_x1[y] = ST7735_FB_W - 1;
+	}
+}
+
+void st7735_fb_set_palette(uint8_t index, uint16_t color) {
+	if(st7735_fb_palette[index & ST7735_FB_MASK] != color) {
+		st7735_fb_palette[index & ST7735_FB_MASK] = color;
+		st7735_fb_invalidate();
+	}
+}
+
+void st7735_fb_set_op(enum ST7735_FB_OP op) {
+	st7735_fb_op = op;
+}
+
+void st7735_fb_clear(uint8_t index) {
+	uint8_t pattern = index & ST7735_FB_MASK;
+	for(uint8_t i = ST7735_FB_BPP; i < 8; i <<= 1) {
+		pattern |= pattern << i;
+	}
+
+	memset(st7735_fb, pattern, sizeof(st7735_fb));
+	st7735_fb_invalidate();
+}
+
+
+static inline void st7735_fb_plot(uint8_t x, uint8_t y, uint8_t index) {
+	uint8_t shift = (ST7735_FB_PER_BYTE - 1 - x % ST7735_FB_PER_BYTE) * ST7735_FB_BPP;
+	uint8_t *p = &st7735_fb[y][x / ST7735_FB_PER_BYTE];
+	uint8_t old = *p;
+
+	if(st7735_fb_op == ST7735_FB_XOR) {
+		*p = old ^ ((index & ST7735_FB_MASK) << shift);
+	} else {
+		*p = (old & ~(ST7735_FB_MASK << shift)) | ((index & ST7735_FB_MASK) << shift);
+	}
+
+	if(*p != old) {
+		st7735_fb_mark(x, x, y);
+	}
+}
+
+void st7735_fb_set_pixel(int16_t x, int16_t y, uint8_t index) {
+	if(x < 0 || x >= ST7735_FB_W || y < 0 || y >= ST7735_FB_H) {
+		return;
+	}
+
+	st7735_fb_plot(x, y, index);
+}
+
+uint8_t st7735_fb_get_pixel(int16_t x, int16_t y) {
+	if(x < 0 || x >= ST7735_FB_W || y < 0 || y >= ST7735_FB_H) {
+		return 0;
+	}
+
+	uint8_t shift = (ST7735_FB_PER_BYTE - 1 - x % ST7735_FB_PER_BYTE) * ST7735_FB_BPP;
+	return (st7735_fb[y][x / ST7735_FB_PER_BYTE] >> shift) & ST7735_FB_MASK;
+}
+
+
+void st7735_fb_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t index) {
+	int16_t x1 = x + w - 1;
+	int16_t y1 = y + h - 1;
+
+	if(x < 0) x = 0;
+	if(y < 0) y = 0;
+	if(x1 >= ST7735_FB_W) x1 = ST7735_FB_W - 1;
+	if(y1 >= ST7735_FB_H) y1 = ST7735_FB_H - 1;
+
+	for(int16_t cur_y = y; cur_y <= y1; cur_y++) {
+		for(int16_t cur_x = x; cur_x <= x1; cur_x++) {
+			st7735_fb_plot(cur_x, cur_y, index);
+		}
+	}
+}
+
+void st7735_fb_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t index) {
+	if(w < 1 || h < 1) {
+		return;
+	}
+
+	st7735_fb_fill_rect(x, y, w, 1, index);
+	if(h > 1) {
+		st7735_fb_fill_rect(x, y + h - 1, w, 1, index);
+	}
+	if(h > 2) {
+		st7735_fb_fill_rect(x, y + 1, 1, h - 2, index);
+		if(w > 1) {
+			st7735_fb_fill_rect(x + w - 1, y + 1, 1, h - 2, index);
+		}
+	}
+}
+
+void st7735_fb_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t index) {
+	int16_t dx = abs(x1 - x0);
+	int16_t dy = -abs(y1 - y0);
+	int8_t x_step = x0 < x1 ? 1 : -1;
+	int8_t y_step = y0 < y1 ? 1 : -1;
+	int16_t err = dx + dy;
+
+	while(1) {
+		st7735_fb_set_pixel(x0, y0, index);
+		if(x0 == x1 && y0 == y1) {
+			break;
+		}
+
+		int16_t err2 = 2 * err;
+		if(err2 >= dy) {
+			err += dy;
+			x0 += x_step;
+		}
+		if(err2 <= dx) {
+			err += dx;
+			y0 += y_step;
+		}
+	}
+}
+
+void st7735_fb_draw_circle(int16_t x0, int16_t y0, uint8_t r, uint8_t index) {
+	int16_t f = 1 - r;
+	int16_t ddF_x = 1;
+	int16_t ddF_y = -2 * r;
+	int16_t x = 0;
+	int16_t y = r;
+
+	// Every pixel is set exactly once, XOR circles would erase themselves
+	if(r == 0) {
+		st7735_fb_set_pixel(x0, y0, index);
+		return;
+	}
+
+	st7735_fb_set_pixel(x0, y0 + r, index);
+	st7735_fb_set_pixel(x0, y0 - r, index);
+	st7735_fb_set_pixel(x0 + r, y0, index);
+	st7735_fb_set_pixel(x0 - r, y0, index);
+
+	for(;;) {
+		if(f >= 0) {
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
+
+		// Past the diagonal, the other octant already has these
+		if(x > y) {
+			break;
+		}
+
+		st7735_fb_set_pixel(x0 + x, y0 + y, index);
+		st7735_fb_set_pixel(x0 - x, y0 + y, index);
+		st7735_fb_set_pixel(x0 + x, y0 - y, index);
+		st7735_fb_set_pixel(x0 - x, y0 - y, index);
+		if(x != y) {
+			st7735_fb_set_pixel(x0 + y, y0 + x, index);
+			st7735_fb_set_pixel(x0 - y, y0 + x, index);
+			st7735_fb_set_pixel(x0 + y, y0 - x, index);
+			st7735_fb_set_pixel(x0 - y, y0 - x, index);
+		}
+	}
+}
+
+void st7735_fb_draw_text(int16_t x, int16_t y, const char *text, const GFXfont *p_font, uint8_t index) {
+	GFXfont font;
+	memcpy_P(&font, p_font, sizeof(GFXfont));
+
+	int16_t cursor_x = x;
+
+	for(; *text; text++) {
+		char c = *text;
+
+		if(c == '\n') {
+			cursor_x = x;
+			y += font.yAdvance;
+			continue;
+		}
+		if(c < font.first || c > font.last) {
+			continue;
+		}
+
+		GFXglyph glyph;
+		memcpy_P(&glyph, &font.glyph[c - font.first], sizeof(GFXglyph));
+
+		const uint8_t *bitmap = font.bitmap + glyph.bitmapOffset;
+		uint8_t bits = 0, bit = 0;
+		for(uint8_t cur_y = 0; cur_y < glyph.height; cur_y++) {
+			for(uint8_t cur_x = 0; cur_x < glyph.width; cur_x++) {
+				if(bit == 0) {
+					bits = pgm_read_byte(bitmap++);
+					bit = 0x80;
+				}
+				if(bits & bit) {
+					st7735_fb_set_pixel(cursor_x + glyph.xOffset + cur_x, y + glyph.yOffset + cur_y, index);
+				}
+				bit >>= 1;
+			}
+		}
+
+		cursor_x += glyph.xAdvance;
+	}
+}
+
+
+// Sends fb row y, columns x0..x1, each pixel doubled
+static void st7735_fb_write_row(uint8_t y, uint8_t x0, uint8_t x1) {
+	for(uint8_t x = x0; x <= x1; x++) {
+		uint8_t shift = (ST7735_FB_PER_BYTE - 1 - x % ST7735_FB_PER_BYTE) * ST7735_FB_BPP;
+		uint16_t color = st7735_fb_palette[(st7735_fb[y][x / ST7735_FB_PER_BYTE] >> shift) & ST7735_FB_MASK];
+		st7735_write_color(color);
+		st7735_write_color(color);
+	}
+}
+
+void st7735_fb_flush(void) {
+	uint8_t y = 0;
+	while(y < ST7735_FB_H) {
+		if(st7735_fb_dirty_x0[y] > st7735_fb_dirty_x1[y]) {
+			y++;
+			continue;
+		}
+
+		// Run of changed rows, sent as one window over their column union
+		uint8_t first_y = y;
+		uint8_t x0 = st7735_fb_dirty_x0[y];
+		uint8_t x1 = st7735_fb_dirty_x1[y];
+		while(y < ST7735_FB_H && st7735_fb_dirty_x0[y] <= st7735_fb_dirty_x1[y]) {
+			if(st7735_fb_dirty_x0[y] < x0) x0 = st7735_fb_dirty_x0[y];
+			if(st7735_fb_dirty_x1[y] > x1) x1 = st7735_fb_dirty_x1[y];
+			st7735_fb_dirty_x0[y] = 0xFF;
+			st7735_fb_dirty_x1[y] = 0;
+			y++;
+		}
+
+		st7735_write_begin(2 * x0, 2 * first_y, 2 * x1 + 1, 2 * y - 1);
+		for(uint8_t row = first_y; row < y; row++) {
+			st7735_fb_write_row(row, x0, x1);
+			st7735_fb_write_row(row, x0, x1);
+		}
+		st7735_write_end();
+	}
+}
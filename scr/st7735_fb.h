@@ -0,0 +1,41 @@
+#ifndef _ST7735_FB_H_
+#define _ST7735_FB_H_
+
+#include <stdint.h>
+
+#include "st7735_font.h"
+
+// Low resolution indexed framebuffer, every pixel is sent as a 2x2 block.
+// 64x64 at 2 bpp takes 1 KB of SRAM, at 1 bpp 512 bytes.
+#define ST7735_FB_W 64
+#define ST7735_FB_H 64
+#define ST7735_FB_BPP 2	// 1 or 2
+#define ST7735_FB_COLORS (1 << ST7735_FB_BPP)
+
+enum ST7735_FB_OP {
+	ST7735_FB_SET,	// pixel = index
+	ST7735_FB_XOR	// pixel ^= index
+};
+
+void st7735_fb_set_palette(uint8_t index, uint16_t color);
+void st7735_fb_set_op(enum ST7735_FB_OP op);
+
+void st7735_fb_clear(uint8_t index);
+void st7735_fb_set_pixel(int16_t x, int16_t y, uint8_t index);
+uint8_t st7735_fb_get_pixel(int16_t x, int16_t y);	// 0 outside
+
+void st7735_fb_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t index);
+void st7735_fb_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t index);
+void st7735_fb_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t index);
+void st7735_fb_draw_circle(int16_t x0, int16_t y0, uint8_t r, uint8_t index);
+void st7735_fb_draw_text(int16_t x, int16_t y, const char *text, const GFXfont *p_font, uint8_t index);
+
+// Marks the whole buffer for the next flush (st7735_fb_clear does too,
+// call one of them before the first flush)
+void st7735_fb_invalidate(void);
+
+// Sends the changed rows, upscaled 2x to the screen origin. Consecutive
+// changed rows share one window.
+void st7735_fb_flush(void);
+
+#endif
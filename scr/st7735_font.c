@@ -13,7 +13,13 @@ void st7735_draw_char(int16_t x, int16_t y, const GFXglyph *glyph, const GFXfont
         return;
     }
 
-    // Clipping will be done by fill rect if necessary
+    // Whole glyph box outside the clip rectangle: nothing to do. Glyphs
+    // that are partly visible are clipped by fill rect.
+    struct st7735_rect r;
+    if(!st7735_clip_rect(x + glyph->xOffset * size, y + glyph->yOffset * size,
+                         glyph->width * size, glyph->height * size, &r)) {
+        return;
+    }
 
     uint8_t  *bitmap = font->bitmap;
     uint16_t bo = glyph->bitmapOffset;
@@ -55,8 +61,42 @@ void st7735_draw_char(int16_t x, int16_t y, const GFXglyph *glyph, const GFXfont
 }
 
 
-void st7735_draw_text(int8_t x, int8_t y, char *text, const GFXfont *p_font,
-                        uint8_t size, uint16_t color) {
+// Unscaled glyph through one window, unset pixels of its box in bg
+static void st7735_draw_char_opaque(int16_t x, int16_t y, const GFXglyph *glyph, const GFXfont *font,
+                                    uint16_t color, uint16_t bg) {
+    int16_t x0 = x + glyph->xOffset;
+    int16_t y0 = y + glyph->yOffset;
+
+    struct st7735_rect r;
+    if(!st7735_clip_rect(x0, y0, glyph->width, glyph->height, &r)) {
+        return;
+    }
+
+    uint8_t first_col = r.x0 - (x0 + st7735_clip.origin_x);
+    uint8_t first_row = r.y0 - (y0 + st7735_clip.origin_y);
+    uint8_t cols = r.x1 - r.x0 + 1;
+    uint8_t rows = r.y1 - r.y0 + 1;
+
+    st7735_write_begin(r.x0, r.y0, r.x1, r.y1);
+
+    // Glyph rows are not padded, unclipped glyphs are a single run
+    PGM_P bitmap = (PGM_P)font->bitmap + glyph->bitmapOffset;
+    uint16_t bit_pos = (uint16_t)first_row * glyph->width + first_col;
+    if(cols == glyph->width) {
+        st7735_write_mono(bitmap, bit_pos, (uint16_t)rows * cols, ST7735_MSB_FIRST, color, bg);
+    } else {
+        for(uint8_t i = 0; i < rows; i++, bit_pos += glyph->width) {
+            st7735_write_mono(bitmap, bit_pos, cols, ST7735_MSB_FIRST, color, bg);
+        }
+    }
+
+    st7735_write_end();
+}
+
+
+static void st7735_draw_glyphs(int16_t x, int16_t y, char *text, const GFXfont *p_font,
+                               uint8_t size, uint16_t color, uint8_t opaque, uint16_t bg) {
+    ST7735_PERF_SCOPE(ST7735_PERF_TEXT);
 
     int16_t cursor_x = x;
     int16_t cursor_y = y;
@@ -76,10 +116,26 @@ void st7735_draw_text(int8_t x, int8_t y, char *text, const GFXfont *p_font,
             GFXglyph glyph;
             memcpy_P(&glyph, &font.glyph[c - font.first], sizeof(GFXglyph));
 
-            st7735_draw_char(cursor_x, cursor_y, &glyph, &font, size, color);
+            if(opaque) {
+                st7735_draw_char_opaque(cursor_x, cursor_y, &glyph, &font, color, bg);
+            } else {
+                st7735_draw_char(cursor_x, cursor_y, &glyph, &font, size, color);
+            }
             cursor_x += glyph.xAdvance * size;
         }
 
     }
 
 }
+
+
+void st7735_draw_text(int16_t x, int16_t y, char *text, const GFXfont *p_font,
+                        uint8_t size, uint16_t color) {
+    st7735_draw_glyphs(x, y, text, p_font, size, color, 0, 0);
+}
+
+
+void st7735_draw_text_opaque(int16_t x, int16_t y, char *text, const GFXfont *p_font,
+                        uint16_t color, uint16_t bg) {
+    st7735_draw_glyphs(x, y, text, p_font, 1, color, 1, bg);
+}
@@ -20,6 +20,11 @@ typedef struct { // Data stored for FONT AS A WHOLE:
 
 
 
-void st7735_draw_text(int8_t x, int8_t y, char *text, const GFXfont *p_font, uint8_t size, uint16_t color);
+void st7735_draw_text(int16_t x, int16_t y, char *text, const GFXfont *p_font, uint8_t size, uint16_t color);
+
+// Unscaled, each glyph box drawn through one window with its unset pixels
+// in bg (the gaps between the boxes are left alone). Cheaper per pixel
+// than the transparent version, which sends a window per run.
+void st7735_draw_text_opaque(int16_t x, int16_t y, char *text, const GFXfont *p_font, uint16_t color, uint16_t bg);
 
 #endif
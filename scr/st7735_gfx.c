@@ -4,18 +4,34 @@
 
 #include "st7735.h"
 
-#define _swap_uint8_t(a, b) { uint8_t t = a; a = b; b = t; }
+#define _swap_int16_t(a, b) { int16_t t = a; a = b; b = t; }
+
+// Nothing of the box x0..x1, y0..y1 (viewport coordinates) is visible
+static inline uint8_t st7735_gfx_rejected(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+	x0 += st7735_clip.origin_x;
+	x1 += st7735_clip.origin_x;
+	y0 += st7735_clip.origin_y;
+	y1 += st7735_clip.origin_y;
+	return x1 < st7735_clip.rect.x0 || x0 > st7735_clip.rect.x1 ||
+		y1 < st7735_clip.rect.y0 || y0 > st7735_clip.rect.y1;
+}
+
+void st7735_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+	ST7735_PERF_SCOPE(ST7735_PERF_LINE);
+
+	if(st7735_gfx_rejected(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0)) {
+		return;
+	}
 
-void st7735_draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint16_t color) {
 	uint8_t steep_dir = abs(y1 - y0) > abs(x1 - x0);
 	if (steep_dir) {
-		_swap_uint8_t(x0, y0);
-		_swap_uint8_t(x1, y1);
+		_swap_int16_t(x0, y0);
+		_swap_int16_t(x1, y1);
 	}
 
 	if (x0 > x1) {
-		_swap_uint8_t(x0, x1);
-		_swap_uint8_t(y0, y1);
+		_swap_int16_t(x0, x1);
+		_swap_int16_t(y0, y1);
 	}
 
   	int16_t dx, dy;
@@ -31,8 +47,8 @@ void st7735_draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint16_t c
 		y_step = -1;
 	}
 
-	uint8_t seg = x0;
-	uint8_t cur_x;
+	int16_t seg = x0;
+	int16_t cur_x;
 	for(cur_x = x0; cur_x <= x1; cur_x++) {
 		err -= dy;
 		if (err < 0) {
@@ -56,8 +72,10 @@ void st7735_draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint16_t c
 }
 
 
-void st7735_draw_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color) {
-	if(w < 1 || h < 1) {
+void st7735_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+	ST7735_PERF_SCOPE(ST7735_PERF_RECT);
+
+	if(w < 1 || h < 1 || st7735_gfx_rejected(x, y, x + w - 1, y + h - 1)) {
 			return;
 	}
 
@@ -68,7 +86,13 @@ void st7735_draw_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color
 }
 
 
-void st7735_draw_circle(uint8_t x0, uint8_t y0, uint8_t r, uint16_t color) {
+void st7735_draw_circle(int16_t x0, int16_t y0, uint8_t r, uint16_t color) {
+	ST7735_PERF_SCOPE(ST7735_PERF_CIRCLE);
+
+	if(st7735_gfx_rejected(x0 - r, y0 - r, x0 + r, y0 + r)) {
+		return;
+	}
+
 	int16_t f = 1 - r;
 	int16_t ddF_x = 1;
 	int16_t ddF_y = -2 * r;
@@ -3,8 +3,8 @@
 
 #include<stdint.h>
 
-void st7735_draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint16_t color);
-void st7735_draw_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h,  uint16_t color);
-void st7735_draw_circle(uint8_t x0, uint8_t y0, uint8_t r, uint16_t color);
+void st7735_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+void st7735_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h,  uint16_t color);
+void st7735_draw_circle(int16_t x0, int16_t y0, uint8_t r, uint16_t color);
 
 #endif
@@ -0,0 +1,191 @@
+#include "st7735_perf.h"
+
+#ifdef ST7735_PERF
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "spi.h"
+#include "stack.h"
+
+struct st7735_perf_counter st7735_perf[ST7735_PERF_COUNT];
+uint32_t st7735_perf_pixels = 0;
+uint16_t st7735_perf_windows = 0;
+
+// Outermost primitive running and the totals when it started
+static uint8_t st7735_perf_depth = 0;
+static uint8_t st7735_perf_id;
+static uint32_t st7735_perf_start_cycles;
+static uint32_t st7735_perf_start_pixels;
+static uint32_t st7735_perf_start_bytes;
+static uint16_t st7735_perf_start_windows;
+
+static uint32_t st7735_perf_frame_cycles = 0;
+static uint8_t st7735_perf_dropped = 0;
+
+// Upper half of the cycle count
+static volatile uint16_t st7735_perf_overflows = 0;
+
+// Telemetry bytes not sent yet, head written here, tail by the interrupt
+static uint8_t st7735_perf_tx[ST7735_PERF_TX_SIZE];
+static volatile uint8_t st7735_perf_tx_head = 0;
+static volatile uint8_t st7735_perf_tx_tail = 0;
+static uint8_t st7735_perf_tx_sum;
+
+ISR(TIMER1_OVF_vect) {
+	st7735_perf_overflows++;
+}
+
+ISR(USART_UDRE_vect) {
+	uint8_t tail = st7735_perf_tx_tail;
+	if(tail == st7735_perf_tx_head) {
+		UCSR0B &= ~(1 << UDRIE0);
+		return;
+	}
+	UDR0 = st7735_perf_tx[tail];
+	tail = (tail + 1) % ST7735_PERF_TX_SIZE;
+	st7735_perf_tx_tail = tail;
+
+	if(tail == st7735_perf_tx_head) {
+		UCSR0B &= ~(1 << UDRIE0);
+	}
+}
+
+void st7735_perf_init(void) {
+	TCCR1A = 0;
+	TCCR1B = (1 << CS10);
+	TIMSK1 |= (1 << TOIE1);
+
+	// Double speed, 9600 baud is 0.2% off at 1 MHz
+	UCSR0A = (1 << U2X0);
+	UBRR0 = (F_CPU + 4UL * ST7735_PERF_BAUD) / (8UL * ST7735_PERF_BAUD) - 1;
+	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+	UCSR0B = (1 << TXEN0);
+
+	st7735_perf_frame_cycles = st7735_perf_cycles();
+}
+
+uint32_t st7735_perf_cycles(void) {
+	uint16_t high, low;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		high = st7735_perf_overflows;
+		low = TCNT1;
+		// Overflowed, but the interrupt has not counted it yet
+		if((TIFR1 & (1 << TOV1)) && low < 0x8000) {
+			high++;
+		}
+	}
+
+	return ((uint32_t)high << 16) | low;
+}
+
+uint8_t st7735_perf_begin(enum ST7735_PERF_ID id) {
+	if(st7735_perf_depth++ == 0) {
+		st7735_perf_id = id;
+		st7735_perf_start_pixels = st7735_perf_pixels;
+		st7735_perf_start_bytes = spi_bytes;
+		st7735_perf_start_windows = st7735_perf_windows;
+		st7735_perf_start_cycles = st7735_perf_cycles();
+	}
+	return id;
+}
+
+void st7735_perf_end(uint8_t *scope) {
+	uint32_t now = st7735_perf_cycles();
+	(void)scope;
+
+	if(--st7735_perf_depth == 0) {
+		struct st7735_perf_counter *c = &st7735_perf[st7735_perf_id];
+		c->calls++;
+		c->windows += st7735_perf_windows - st7735_perf_start_windows;
+		c->pixels += st7735_perf_pixels - st7735_perf_start_pixels;
+		c->bytes += spi_bytes - st7735_perf_start_bytes;
+		c->cycles += now - st7735_perf_start_cycles;
+	}
+}
+
+static void st7735_perf_put(uint8_t byte) {
+	uint8_t head = st7735_perf_tx_head;
+	st7735_perf_tx[head] = byte;
+	st7735_perf_tx_head = (head + 1) % ST7735_PERF_TX_SIZE;
+	st7735_perf_tx_sum += byte;
+}
+
+// Little endian
+static void st7735_perf_put16(uint16_t value) {
+	st7735_perf_put(value);
+	st7735_perf_put(value >> 8);
+}
+
+static void st7735_perf_put32(uint32_t value) {
+	st7735_perf_put16(value);
+	st7735_perf_put16(value >> 16);
+}
+
+// Frame: 0xA5 0x5A, payload length, payload, sum of the payload bytes.
+// Payload: tag, frames dropped so far, stack never used (u16), cycles since
+// the last frame (u32), then for each primitive called: id, calls,
+// windows (u16), pixels, bytes, cycles (u32).
+#define ST7735_PERF_HEADER 8
+#define ST7735_PERF_RECORD 17
+
+// A frame with every primitive has to fit, one byte of the ring stays free
+_Static_assert(ST7735_PERF_TX_SIZE - 1 >= 3 + ST7735_PERF_HEADER + ST7735_PERF_COUNT * ST7735_PERF_RECORD + 1,
+	"ST7735_PERF_TX_SIZE is too small for a frame with all primitives");
+_Static_assert(ST7735_PERF_TX_SIZE <= 256 && !(ST7735_PERF_TX_SIZE & (ST7735_PERF_TX_SIZE - 1)),
+	"ST7735_PERF_TX_SIZE has to be a power of two up to 256");
+
+void st7735_perf_frame(uint8_t tag) {
+	uint32_t now = st7735_perf_cycles();
+
+	uint8_t length = ST7735_PERF_HEADER;
+	for(uint8_t i = 0; i < ST7735_PERF_COUNT; i++) {
+		if(st7735_perf[i].calls) {
+			length += ST7735_PERF_RECORD;
+		}
+	}
+
+	uint8_t used = (uint8_t)(st7735_perf_tx_head - st7735_perf_tx_tail) % ST7735_PERF_TX_SIZE;
+	if(ST7735_PERF_TX_SIZE - 1 - used < length + 4) {
+		if(st7735_perf_dropped < 0xFF) {
+			st7735_perf_dropped++;
+		}
+	} else {
+		st7735_perf_put(0xA5);
+		st7735_perf_put(0x5A);
+		st7735_perf_put(length);
+
+		st7735_perf_tx_sum = 0;
+		st7735_perf_put(tag);
+		st7735_perf_put(st7735_perf_dropped);
+		st7735_perf_put16(stack_unused());
+		st7735_perf_put32(now - st7735_perf_frame_cycles);
+		for(uint8_t i = 0; i < ST7735_PERF_COUNT; i++) {
+			const struct st7735_perf_counter *c = &st7735_perf[i];
+			if(!c->calls) {
+				continue;
+			}
+			st7735_perf_put(i);
+			st7735_perf_put16(c->calls);
+			st7735_perf_put16(c->windows);
+			st7735_perf_put32(c->pixels);
+			st7735_perf_put32(c->bytes);
+			st7735_perf_put32(c->cycles);
+		}
+		st7735_perf_put(st7735_perf_tx_sum);
+
+		// UCSR0B is no I/O register, the interrupt must not clear UDRIE
+		// between reading and writing it back
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			UCSR0B |= (1 << UDRIE0);
+		}
+	}
+
+	memset(st7735_perf, 0, sizeof(st7735_perf));
+	st7735_perf_frame_cycles = now;
+}
+
+#endif
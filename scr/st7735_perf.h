@@ -0,0 +1,78 @@
+#ifndef _ST7735_PERF_H_
+#define _ST7735_PERF_H_
+
+#include <stdint.h>
+
+// What the drawing primitives cost, counted on the device and sent as
+// binary telemetry frames over USART0 (TXD, 9600 baud 8N1). Build with
+// -DST7735_PERF; without it everything below compiles to nothing.
+//
+//   st7735_perf_init();			// after sei()
+//   ...
+//   draw a frame
+//   st7735_perf_frame(tag);		// queues the counters, then clears them
+//
+// tools/st7735_perf.py decodes the stream into a table per tag. A
+// primitive called from another one (fill rect from a circle, ...) counts
+// as part of the outer one. The counting itself adds a few cycles per
+// byte and per call.
+
+enum ST7735_PERF_ID {
+	ST7735_PERF_PIXEL,
+	ST7735_PERF_FILL_RECT,
+	ST7735_PERF_GRADIENT,
+	ST7735_PERF_BITMAP,
+	ST7735_PERF_MONO_BITMAP,
+	ST7735_PERF_LINE,
+	ST7735_PERF_RECT,
+	ST7735_PERF_CIRCLE,
+	ST7735_PERF_TEXT,
+	ST7735_PERF_COUNT
+};
+
+struct st7735_perf_counter {
+	uint16_t calls;
+	uint16_t windows;	// address window setups
+	uint32_t pixels;
+	uint32_t bytes;		// over SPI, commands included
+	uint32_t cycles;	// CPU cycles (Timer1 at clk/1)
+};
+
+#ifdef ST7735_PERF
+
+#define ST7735_PERF_BAUD 9600
+
+// Frames that do not fit into the rest of the buffer are dropped (and
+// counted), so sending never waits. Room for a frame with all primitives
+// (165 bytes); the ring indexes are bytes, so a power of two up to 256.
+#define ST7735_PERF_TX_SIZE 256
+
+extern struct st7735_perf_counter st7735_perf[ST7735_PERF_COUNT];
+extern uint32_t st7735_perf_pixels;
+extern uint16_t st7735_perf_windows;
+
+// Starts Timer1 (free running, clk/1) and USART0
+void st7735_perf_init(void);
+uint32_t st7735_perf_cycles(void);
+
+uint8_t st7735_perf_begin(enum ST7735_PERF_ID id);
+void st7735_perf_end(uint8_t *scope);
+void st7735_perf_frame(uint8_t tag);
+
+// Counts the rest of the enclosing block (early returns included) as id
+#define ST7735_PERF_SCOPE(id) \
+	uint8_t st7735_perf_scope __attribute__((cleanup(st7735_perf_end), unused)) = st7735_perf_begin(id)
+#define ST7735_PERF_PIXELS(n) (st7735_perf_pixels += (n))
+#define ST7735_PERF_WINDOW() (st7735_perf_windows++)
+
+#else
+
+#define ST7735_PERF_SCOPE(id)
+#define ST7735_PERF_PIXELS(n)
+#define ST7735_PERF_WINDOW()
+#define st7735_perf_init()
+#define st7735_perf_frame(tag)
+
+#endif
+
+#endif
@@ -0,0 +1,153 @@
+#include "st7735_rotozoom.h"
+
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+
+#include "st7735.h"
+
+// Destination walk shared by both formats. Source coordinates are 16.16
+// fixed point and advance by a constant step per screen pixel and row.
+struct st7735_rotozoom {
+	int16_t x0, y0, x1, y1;		// clipped destination box
+	int32_t u, v;				// source position at (x0, y0)
+	int32_t du_dx, dv_dx;		// per screen column
+	int32_t du_dy, dv_dy;		// per screen row
+	uint8_t w, h;
+};
+
+// Sets up the walk, returns 0 when nothing is visible
+static uint8_t st7735_rotozoom_setup(struct st7735_rotozoom *rz, int16_t cx, int16_t cy,
+                                     uint8_t w, uint8_t h, uint8_t angle, q8_8_t scale) {
+	if(scale <= 0 || w == 0 || h == 0) {
+		return 0;
+	}
+
+	q1_15_t c = fix_cos(angle);
+	q1_15_t s = fix_sin(angle);
+
+	// Half size of the rotated and scaled box, rounded up
+	uint32_t ac = abs(c), as = abs(s);
+	uint32_t half_w = (((ac * w + as * h) >> 15) * (uint16_t)scale >> 9) + 1;
+	uint32_t half_h = (((as * w + ac * h) >> 15) * (uint16_t)scale >> 9) + 1;
+
+	rz->x0 = cx - half_w;
+	rz->x1 = cx + half_w;
+	rz->y0 = cy - half_h;
+	rz->y1 = cy + half_h;
+	if(rz->x0 < 0) rz->x0 = 0;
+	if(rz->y0 < 0) rz->y0 = 0;
+	if(rz->x1 >= st7735_width) rz->x1 = st7735_width - 1;
+	if(rz->y1 >= st7735_height) rz->y1 = st7735_height - 1;
+	if(rz->x0 > rz->x1 || rz->y0 > rz->y1) {
+		return 0;
+	}
+
+	// Inverse mapping: source = R(-angle) * (screen - center) / scale + size / 2.
+	// Q1.15 tops out at 32767, stretch to 16.16 so that 1.0 is exact.
+	int32_t c16 = ((int32_t)c << 16) / 32767;
+	int32_t s16 = ((int32_t)s << 16) / 32767;
+	rz->du_dx = (c16 << 8) / scale;
+	rz->dv_dx = -(s16 << 8) / scale;
+	rz->du_dy = (s16 << 8) / scale;
+	rz->dv_dy = (c16 << 8) / scale;
+
+	// Sample at pixel centers so rounding in the steps never flips a pixel
+	int16_t dx = rz->x0 - cx;
+	int16_t dy = rz->y0 - cy;
+	rz->u = ((int32_t)w << 15) + dx * rz->du_dx + dy * rz->du_dy + (rz->du_dx + rz->du_dy) / 2;
+	rz->v = ((int32_t)h << 15) + dx * rz->dv_dx + dy * rz->dv_dy + (rz->dv_dx + rz->dv_dy) / 2;
+	rz->w = w;
+	rz->h = h;
+
+	return 1;
+}
+
+static inline uint8_t st7735_rotozoom_inside(const struct st7735_rotozoom *rz, int32_t u, int32_t v) {
+	// Negative coordinates turn into large unsigned values
+	return (uint16_t)(u >> 16) < rz->w && (uint16_t)(v >> 16) < rz->h;
+}
+
+
+void st7735_draw_bitmap_rotozoom(int16_t cx, int16_t cy, const uint16_t *bitmap,
+                                 uint8_t angle, q8_8_t scale) {
+	struct st7735_rotozoom rz;
+	if(!st7735_rotozoom_setup(&rz, cx, cy, pgm_read_word(bitmap), pgm_read_word(bitmap + 1), angle, scale)) {
+		return;
+	}
+	bitmap += 2;
+
+	for(int16_t y = rz.y0; y <= rz.y1; y++, rz.u += rz.du_dy, rz.v += rz.dv_dy) {
+		int32_t u = rz.u;
+		int32_t v = rz.v;
+		int16_t x = rz.x0;
+
+		// Skip to the image, nothing is sent for these
+		while(x <= rz.x1 && !st7735_rotozoom_inside(&rz, u, v)) {
+			x++;
+			u += rz.du_dx;
+			v += rz.dv_dx;
+		}
+		if(x > rz.x1) {
+			continue;
+		}
+
+		// The image is convex: one run up to the first pixel outside. The
+		// window may reach further, the unused end is simply not written.
+		st7735_write_begin(x, y, rz.x1, y);
+		while(x <= rz.x1 && st7735_rotozoom_inside(&rz, u, v)) {
+			st7735_write_color(pgm_read_word(bitmap + (uint8_t)(v >> 16) * rz.w + (uint8_t)(u >> 16)));
+			x++;
+			u += rz.du_dx;
+			v += rz.dv_dx;
+		}
+		st7735_write_end();
+	}
+}
+
+void st7735_draw_mono_bitmap_rotozoom(int16_t cx, int16_t cy, const uint8_t *bitmap,
+                                      uint8_t angle, q8_8_t scale,
+                                      uint16_t color_set, uint16_t color_unset, uint8_t transparent) {
+	struct st7735_rotozoom rz;
+	if(!st7735_rotozoom_setup(&rz, cx, cy, pgm_read_byte(bitmap), pgm_read_byte(bitmap + 1), angle, scale)) {
+		return;
+	}
+	bitmap += 2;
+
+	for(int16_t y = rz.y0; y <= rz.y1; y++, rz.u += rz.du_dy, rz.v += rz.dv_dy) {
+		int32_t u = rz.u;
+		int32_t v = rz.v;
+		uint8_t in_image = 0;
+		uint8_t in_run = 0;
+
+		for(int16_t x = rz.x0; x <= rz.x1; x++, u += rz.du_dx, v += rz.dv_dx) {
+			if(!st7735_rotozoom_inside(&rz, u, v)) {
+				if(in_image) {
+					break;	// left the image, the rest of the row is outside
+				}
+				continue;
+			}
+			in_image = 1;
+
+			uint16_t pos = (uint8_t)(v >> 16) * rz.w + (uint8_t)(u >> 16);
+			uint8_t set = pgm_read_byte(bitmap + (pos >> 3)) & (1 << (pos & 7));
+
+			if(!set && transparent) {
+				if(in_run) {
+					st7735_write_end();
+					in_run = 0;
+				}
+				continue;
+			}
+
+			if(!in_run) {
+				st7735_write_begin(x, y, rz.x1, y);
+				in_run = 1;
+			}
+			st7735_write_color(set ? color_set : color_unset);
+		}
+
+		if(in_run) {
+			st7735_write_end();
+		}
+	}
+}
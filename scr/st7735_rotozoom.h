@@ -0,0 +1,24 @@
+#ifndef _ST7735_ROTOZOOM_H_
+#define _ST7735_ROTOZOOM_H_
+
+#include <stdint.h>
+
+#include "fixmath.h"
+
+// Draws a PROGMEM bitmap rotated by angle (binary angle, see fixmath.h) and
+// scaled by scale (Q8.8, Q8_8(1) = original size, must be > 0) about its
+// center, which is placed at (cx, cy). Every screen row inside the image
+// is sent as one run; pixels outside the image are never sent.
+
+// RGB565 bitmap in the logo.h layout (width, height, pixels; uint16_t)
+void st7735_draw_bitmap_rotozoom(int16_t cx, int16_t cy, const uint16_t *bitmap,
+                                 uint8_t angle, q8_8_t scale);
+
+// 1 bpp bitmap in the logo_bw.h layout (width, height, LSB first bits).
+// With transparent set, unset pixels are skipped: the row run ends there
+// and the next set pixel opens a new one.
+void st7735_draw_mono_bitmap_rotozoom(int16_t cx, int16_t cy, const uint8_t *bitmap,
+                                      uint8_t angle, q8_8_t scale,
+                                      uint16_t color_set, uint16_t color_unset, uint8_t transparent);
+
+#endif
@@ -0,0 +1,261 @@
+#include "st7735_sprite.h"
+
+#include <stddef.h>
+
+enum ST7735_SPRITE_FLAGS {
+	SPRITE_USED = 0x01,
+	SPRITE_VISIBLE = 0x02,
+	SPRITE_ON_SCREEN = 0x04,	// drawn_x/drawn_y are valid
+	SPRITE_CHANGED = 0x08
+};
+
+struct st7735_sprite {
+	const uint16_t *image;
+	int16_t x, y;				// requested position
+	int16_t drawn_x, drawn_y;	// position currently on screen
+	uint8_t w, h;
+	uint8_t drawn_w, drawn_h;
+	int8_t z;
+	uint8_t flags;
+};
+
+static struct st7735_sprite st7735_sprites[ST7735_SPRITES];
+static uint16_t st7735_sprite_line[ST7735_SPRITE_LINE];
+
+static uint16_t st7735_sprite_bg_color = ST7735_COLOR_BLACK;
+static const uint16_t *st7735_sprite_bg_tile = NULL;
+
+
+void st7735_sprite_set_background(uint16_t color, const uint16_t *tile) {
+	st7735_sprite_bg_color = color;
+	st7735_sprite_bg_tile = tile;
+}
+
+uint8_t st7735_sprite_add(const uint16_t *image, int16_t x, int16_t y, int8_t z) {
+	for(uint8_t id = 0; id < ST7735_SPRITES; id++) {
+		struct st7735_sprite *s = &st7735_sprites[id];
+		if(!(s->flags & SPRITE_USED)) {
+			s->flags = SPRITE_USED | SPRITE_VISIBLE | SPRITE_CHANGED;
+			s->x = x;
+			s->y = y;
+			s->z = z;
+			st7735_sprite_set_image(id, image);
+			return id;
+		}
+	}
+
+	return ST7735_SPRITE_NONE;
+}
+
+void st7735_sprite_remove(uint8_t id) {
+	// The slot is freed once the next update has repainted its old area
+	st7735_sprites[id].image = NULL;
+	st7735_sprites[id].flags &= ~SPRITE_VISIBLE;
+	st7735_sprites[id].flags |= SPRITE_CHANGED;
+}
+
+void st7735_sprite_move(uint8_t id, int16_t x, int16_t y) {
+	struct st7735_sprite *s = &st7735_sprites[id];
+	if(s->x != x || s->y != y) {
+		s->x = x;
+		s->y = y;
+		s->flags |= SPRITE_CHANGED;
+	}
+}
+
+void st7735_sprite_set_image(uint8_t id, const uint16_t *image) {
+	struct st7735_sprite *s = &st7735_sprites[id];
+	s->image = image;
+	s->w = pgm_read_word(image);
+	s->h = pgm_read_word(image + 1);
+	s->flags |= SPRITE_CHANGED;
+}
+
+void st7735_sprite_set_z(uint8_t id, int8_t z) {
+	st7735_sprites[id].z = z;
+	st7735_sprites[id].flags |= SPRITE_CHANGED;
+}
+
+void st7735_sprite_show(uint8_t id, uint8_t visible) {
+	struct st7735_sprite *s = &st7735_sprites[id];
+	if(visible) {
+		s->flags |= SPRITE_VISIBLE;
+	} else {
+		s->flags &= ~SPRITE_VISIBLE;
+	}
+	s->flags |= SPRITE_CHANGED;
+}
+
+
+// Fills line[0 .. x1-x0] with the background of screen row y
+static void st7735_sprite_fill_background(uint8_t x0, uint8_t x1, uint8_t y) {
+	uint8_t count = x1 - x0 + 1;
+
+	if(st7735_sprite_bg_tile == NULL) {
+		for(uint8_t i = 0; i < count; i++) {
+			st7735_sprite_line[i] = st7735_sprite_bg_color;
+		}
+		return;
+	}
+
+	uint8_t tw = pgm_read_word(st7735_sprite_bg_tile);
+	uint8_t th = pgm_read_word(st7735_sprite_bg_tile + 1);
+	const uint16_t *row = st7735_sprite_bg_tile + 2 + (y % th) * tw;
+	uint8_t tx = x0 % tw;
+
+	for(uint8_t i = 0; i < count; i++) {
+		st7735_sprite_line[i] = pgm_read_word(row + tx);
+		if(++tx == tw) {
+			tx = 0;
+		}
+	}
+}
+
+// Copies the part of sprite s covering row y, columns x0..x1 into the line
+static void st7735_sprite_blend(const struct st7735_sprite *s, uint8_t x0, uint8_t x1, uint8_t y) {
+	int16_t first = s->x > x0 ? s->x : x0;
+	int16_t last = s->x + s->w - 1 < x1 ? s->x + s->w - 1 : x1;
+	if(first > last) {
+		return;
+	}
+
+	const uint16_t *src = s->image + 2 + (y - s->y) * s->w + (first - s->x);
+	uint16_t *dst = &st7735_sprite_line[first - x0];
+
+	for(int16_t cur_x = first; cur_x <= last; cur_x++) {
+		uint16_t color = pgm_read_word(src++);
+		if(color != ST7735_SPRITE_KEY) {
+			*dst = color;
+		}
+		dst++;
+	}
+}
+
+// Composes and sends the screen area x0..x1, y0..y1 (inclusive, on screen)
+static void st7735_sprite_render(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+	// Visible sprites overlapping the area, sorted by z (bottom first)
+	uint8_t order[ST7735_SPRITES];
+	uint8_t count = 0;
+
+	for(uint8_t id = 0; id < ST7735_SPRITES; id++) {
+		const struct st7735_sprite *s = &st7735_sprites[id];
+		if(!(s->flags & SPRITE_VISIBLE) ||
+		   s->x > x1 || s->x + s->w <= x0 || s->y > y1 || s->y + s->h <= y0) {
+			continue;
+		}
+
+		uint8_t pos = count++;
+		while(pos > 0 && st7735_sprites[order[pos - 1]].z > s->z) {
+			order[pos] = order[pos - 1];
+			pos--;
+		}
+		order[pos] = id;
+	}
+
+	// Column strips as wide as the line buffer, one window each
+	for(uint8_t sx0 = x0; ; sx0 += ST7735_SPRITE_LINE) {
+		uint8_t sx1 = (x1 - sx0 >= ST7735_SPRITE_LINE) ? sx0 + ST7735_SPRITE_LINE - 1 : x1;
+
+		st7735_write_begin(sx0, y0, sx1, y1);
+		for(uint8_t y = y0; ; y++) {
+			st7735_sprite_fill_background(sx0, sx1, y);
+
+			for(uint8_t i = 0; i < count; i++) {
+				const struct st7735_sprite *s = &st7735_sprites[order[i]];
+				if(y >= s->y && y < s->y + s->h) {
+					st7735_sprite_blend(s, sx0, sx1, y);
+				}
+			}
+
+			for(uint8_t i = 0; i <= sx1 - sx0; i++) {
+				st7735_write_color(st7735_sprite_line[i]);
+			}
+
+			if(y == y1) {
+				break;
+			}
+		}
+		st7735_write_end();
+
+		if(sx1 == x1) {
+			break;
+		}
+	}
+}
+
+// Clips x, y, w, h to the screen and renders it
+static void st7735_sprite_render_clipped(int16_t x, int16_t y, uint8_t w, uint8_t h) {
+	int16_t x1 = x + w - 1;
+	int16_t y1 = y + h - 1;
+
+	if(x < 0) x = 0;
+	if(y < 0) y = 0;
+	if(x1 >= st7735_width) x1 = st7735_width - 1;
+	if(y1 >= st7735_height) y1 = st7735_height - 1;
+
+	if(x > x1 || y > y1) {
+		return;
+	}
+
+	st7735_sprite_render(x, y, x1, y1);
+}
+
+
+void st7735_sprite_update(void) {
+	for(uint8_t id = 0; id < ST7735_SPRITES; id++) {
+		struct st7735_sprite *s = &st7735_sprites[id];
+		if(!(s->flags & SPRITE_CHANGED)) {
+			continue;
+		}
+
+		uint8_t old_shown = s->flags & SPRITE_ON_SCREEN;
+		uint8_t new_shown = s->flags & SPRITE_VISIBLE;
+
+		if(old_shown && new_shown &&
+		   s->x <= s->drawn_x + s->drawn_w && s->drawn_x <= s->x + s->w &&
+		   s->y <= s->drawn_y + s->drawn_h && s->drawn_y <= s->y + s->h) {
+			// Old and new areas touch: send their union in one go
+			int16_t x = s->x < s->drawn_x ? s->x : s->drawn_x;
+			int16_t y = s->y < s->drawn_y ? s->y : s->drawn_y;
+			int16_t x1 = s->x + s->w > s->drawn_x + s->drawn_w ? s->x + s->w : s->drawn_x + s->drawn_w;
+			int16_t y1 = s->y + s->h > s->drawn_y + s->drawn_h ? s->y + s->h : s->drawn_y + s->drawn_h;
+			st7735_sprite_render_clipped(x, y, x1 - x, y1 - y);
+		} else {
+			if(old_shown) {
+				st7735_sprite_render_clipped(s->drawn_x, s->drawn_y, s->drawn_w, s->drawn_h);
+			}
+			if(new_shown) {
+				st7735_sprite_render_clipped(s->x, s->y, s->w, s->h);
+			}
+		}
+
+		s->flags &= ~(SPRITE_CHANGED | SPRITE_ON_SCREEN);
+		if(new_shown) {
+			s->flags |= SPRITE_ON_SCREEN;
+			s->drawn_x = s->x;
+			s->drawn_y = s->y;
+			s->drawn_w = s->w;
+			s->drawn_h = s->h;
+		} else if(s->image == NULL) {
+			s->flags = 0;
+		}
+	}
+}
+
+void st7735_sprite_redraw(void) {
+	st7735_sprite_render(0, 0, st7735_width - 1, st7735_height - 1);
+
+	for(uint8_t id = 0; id < ST7735_SPRITES; id++) {
+		struct st7735_sprite *s = &st7735_sprites[id];
+		s->flags &= ~(SPRITE_CHANGED | SPRITE_ON_SCREEN);
+		if(s->flags & SPRITE_VISIBLE) {
+			s->flags |= SPRITE_ON_SCREEN;
+			s->drawn_x = s->x;
+			s->drawn_y = s->y;
+			s->drawn_w = s->w;
+			s->drawn_h = s->h;
+		} else if(s->image == NULL) {
+			s->flags = 0;
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef _ST7735_SPRITE_H_
+#define _ST7735_SPRITE_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "st7735.h"
+
+#define ST7735_SPRITES 8
+
+// Width in pixels of the composition line buffer (2 bytes per pixel).
+// Wider update areas are sent as several column strips.
+#define ST7735_SPRITE_LINE 32
+
+// Image pixels of this color are transparent
+#define ST7735_SPRITE_KEY ST7735_COLOR_MAGENTA
+
+#define ST7735_SPRITE_NONE 0xFF
+
+// Sprite images use the logo.h layout: width, height, then RGB565 pixels,
+// all uint16_t in PROGMEM.
+
+// Background shown behind the sprites: a solid color, or a PROGMEM tile in
+// the same layout as the sprite images repeated from the screen origin
+// (tile == NULL for solid).
+void st7735_sprite_set_background(uint16_t color, const uint16_t *tile);
+
+// Returns the sprite id or ST7735_SPRITE_NONE if all slots are in use.
+// Higher z is drawn on top.
+uint8_t st7735_sprite_add(const uint16_t *image, int16_t x, int16_t y, int8_t z);
+void st7735_sprite_remove(uint8_t id);
+
+void st7735_sprite_move(uint8_t id, int16_t x, int16_t y);
+void st7735_sprite_set_image(uint8_t id, const uint16_t *image);
+void st7735_sprite_set_z(uint8_t id, int8_t z);
+void st7735_sprite_show(uint8_t id, uint8_t visible);
+
+// Redraws the old and new area of every changed sprite, nothing else
+void st7735_sprite_update(void);
+
+// Redraws the whole screen (background and all sprites)
+void st7735_sprite_redraw(void);
+
+#endif
@@ -0,0 +1,79 @@
+#include "st7735_stamp.h"
+
+#include "st7735.h"
+
+void st7735_draw_stamp(int16_t x, int16_t y, const uint8_t *stamp, uint16_t color) {
+	uint8_t w = pgm_read_byte(stamp++);
+	uint8_t h = pgm_read_byte(stamp++);
+	uint8_t stride = (w + 7) / 8;
+
+	struct st7735_rect r;
+	if(!st7735_clip_rect(x, y, w, h, &r)) {
+		return;
+	}
+
+	// Only the visible rows, runs are clipped by fill rect
+	uint8_t first_row = r.y0 - (y + st7735_clip.origin_y);
+	uint8_t last_row = r.y1 - (y + st7735_clip.origin_y);
+
+	stamp += first_row * stride;
+	for(uint8_t i = first_row; i <= last_row; i++, stamp += stride) {
+		int16_t cur_y = y + i;
+
+		uint8_t bits = 0;
+		uint8_t run_len = 0;
+		for(uint8_t j = 0; j < w; j++) {
+			if((j & 7) == 0) {
+				bits = pgm_read_byte(stamp + (j >> 3));
+			}
+
+			if(bits & 0x80) {
+				run_len++;
+			} else if(run_len > 0) {
+				st7735_fill_rect(x + j - run_len, cur_y, run_len, 1, color);
+				run_len = 0;
+			}
+
+			bits <<= 1;
+		}
+
+		// Draw rest of row
+		if(run_len > 0) {
+			st7735_fill_rect(x + w - run_len, cur_y, run_len, 1, color);
+		}
+	}
+}
+
+
+void st7735_draw_stamp_opaque(int16_t x, int16_t y, const uint8_t *stamp, uint16_t color, uint16_t bg) {
+	uint8_t w = pgm_read_byte(stamp++);
+	uint8_t h = pgm_read_byte(stamp++);
+	uint8_t stride = (w + 7) / 8;
+
+	struct st7735_rect r;
+	if(!st7735_clip_rect(x, y, w, h, &r)) {
+		return;
+	}
+
+	// Visible part of the stamp, in stamp coordinates
+	uint8_t first_col = r.x0 - (x + st7735_clip.origin_x);
+	uint8_t first_row = r.y0 - (y + st7735_clip.origin_y);
+	uint8_t cols = r.x1 - r.x0 + 1;
+	uint8_t rows = r.y1 - r.y0 + 1;
+
+	st7735_write_begin(r.x0, r.y0, r.x1, r.y1);
+
+	// Rows are padded to whole bytes, so only widths of a multiple of 8
+	// shown in full make a single run
+	stamp += first_row * stride;
+	if(cols == w && (w & 7) == 0) {
+		st7735_write_mono((PGM_P)stamp, 0, (uint16_t)rows * w, ST7735_MSB_FIRST, color, bg);
+	}
+	else {
+		for(uint8_t i = 0; i < rows; i++, stamp += stride) {
+			st7735_write_mono((PGM_P)stamp, first_col, cols, ST7735_MSB_FIRST, color, bg);
+		}
+	}
+
+	st7735_write_end();
+}
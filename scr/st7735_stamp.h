@@ -0,0 +1,18 @@
+#ifndef _ST7735_STAMP_H_
+#define _ST7735_STAMP_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// A stamp is a small 1 bpp mask in PROGMEM:
+//   width, height, then one row after another, each row (width + 7) / 8
+//   bytes, MSB first (same bit order as the GFX glyphs).
+
+// Draws the set pixels only, one window per horizontal run of set pixels.
+// Drawing the same stamp again with the background color erases it.
+void st7735_draw_stamp(int16_t x, int16_t y, const uint8_t *stamp, uint16_t color);
+
+// Draws the whole stamp box through one window, unset pixels in bg.
+void st7735_draw_stamp_opaque(int16_t x, int16_t y, const uint8_t *stamp, uint16_t color, uint16_t bg);
+
+#endif
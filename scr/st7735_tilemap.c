@@ -0,0 +1,126 @@
+#include "st7735_tilemap.h"
+
+#include <stddef.h>
+
+#include "st7735.h"
+
+#if ST7735_TILE_SIZE != 8 && ST7735_TILE_SIZE != 16
+#error "ST7735_TILE_SIZE must be 8 or 16"
+#endif
+
+#if ST7735_TILEMAP_W > 16
+#error "Dirty bits hold at most 16 tiles per row"
+#endif
+
+static uint8_t st7735_tilemap[ST7735_TILEMAP_H][ST7735_TILEMAP_W];
+static uint16_t st7735_tilemap_dirty[ST7735_TILEMAP_H];	// bit n = column n
+
+static const uint16_t *st7735_tileset = NULL;
+static const uint8_t *st7735_mono_tileset = NULL;
+static uint16_t st7735_tile_color_set, st7735_tile_color_unset;
+
+
+void st7735_tilemap_set_tileset(const uint16_t *sheet) {
+	st7735_tileset = sheet + 2;
+	st7735_mono_tileset = NULL;
+}
+
+void st7735_tilemap_set_mono_tileset(const uint8_t *sheet, uint16_t color_set, uint16_t color_unset) {
+	st7735_mono_tileset = sheet + 2;
+	st7735_tileset = NULL;
+	st7735_tile_color_set = color_set;
+	st7735_tile_color_unset = color_unset;
+}
+
+void st7735_tilemap_set(uint8_t col, uint8_t row, uint8_t tile) {
+	if(st7735_tilemap[row][col] != tile) {
+		st7735_tilemap[row][col] = tile;
+		st7735_tilemap_dirty[row] |= 1U << col;
+	}
+}
+
+uint8_t st7735_tilemap_get(uint8_t col, uint8_t row) {
+	return st7735_tilemap[row][col];
+}
+
+void st7735_tilemap_fill(uint8_t tile) {
+	for(uint8_t row = 0; row < ST7735_TILEMAP_H; row++) {
+		for(uint8_t col = 0; col < ST7735_TILEMAP_W; col++) {
+			st7735_tilemap_set(col, row, tile);
+		}
+	}
+}
+
+void st7735_tilemap_invalidate(void) {
+	for(uint8_t row = 0; row < ST7735_TILEMAP_H; row++) {
+		st7735_tilemap_dirty[row] = (uint16_t)((1UL << ST7735_TILEMAP_W) - 1);
+	}
+}
+
+
+// Sends pixel row line (0 .. tile size-1) of tile
+static void st7735_tile_write_line(uint8_t tile, uint8_t line) {
+	if(st7735_tileset != NULL) {
+		const uint16_t *src = st7735_tileset + ((uint16_t)tile * ST7735_TILE_SIZE + line) * ST7735_TILE_SIZE;
+		for(uint8_t i = 0; i < ST7735_TILE_SIZE; i++) {
+			st7735_write_color(pgm_read_word(src++));
+		}
+	} else {
+		const uint8_t *src = st7735_mono_tileset + ((uint16_t)tile * ST7735_TILE_SIZE + line) * (ST7735_TILE_SIZE / 8);
+		st7735_write_mono((PGM_P)src, 0, ST7735_TILE_SIZE, ST7735_LSB_FIRST, st7735_tile_color_set, st7735_tile_color_unset);
+	}
+}
+
+// Sends the tiles first_col .. last_col of row through one window
+static void st7735_tilemap_write_run(uint8_t row, uint8_t first_col, uint8_t last_col) {
+	uint8_t x0 = first_col * ST7735_TILE_SIZE;
+	uint8_t y0 = row * ST7735_TILE_SIZE;
+
+	st7735_write_begin(x0, y0, x0 + (last_col - first_col + 1) * ST7735_TILE_SIZE - 1, y0 + ST7735_TILE_SIZE - 1);
+
+	for(uint8_t line = 0; line < ST7735_TILE_SIZE; line++) {
+		for(uint8_t col = first_col; col <= last_col; col++) {
+			st7735_tile_write_line(st7735_tilemap[row][col], line);
+		}
+	}
+
+	st7735_write_end();
+}
+
+void st7735_tilemap_flush(void) {
+	if(st7735_tileset == NULL && st7735_mono_tileset == NULL) {
+		return;
+	}
+
+	// Only whole tiles on screen are sent
+	uint8_t cols = st7735_width / ST7735_TILE_SIZE;
+	uint8_t rows = st7735_height / ST7735_TILE_SIZE;
+	if(cols > ST7735_TILEMAP_W) cols = ST7735_TILEMAP_W;
+	if(rows > ST7735_TILEMAP_H) rows = ST7735_TILEMAP_H;
+	uint16_t visible = (uint16_t)((1UL << cols) - 1);
+
+	for(uint8_t row = 0; row < rows; row++) {
+		uint16_t dirty = st7735_tilemap_dirty[row] & visible;
+		if(dirty == 0) {
+			continue;
+		}
+		st7735_tilemap_dirty[row] &= ~dirty;
+
+		uint8_t col = 0;
+		while(dirty) {
+			// Skip clean tiles, then collect the run of dirty ones
+			while(!(dirty & 1)) {
+				dirty >>= 1;
+				col++;
+			}
+
+			uint8_t first_col = col;
+			while(dirty & 1) {
+				dirty >>= 1;
+				col++;
+			}
+
+			st7735_tilemap_write_run(row, first_col, col - 1);
+		}
+	}
+}
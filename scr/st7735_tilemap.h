@@ -0,0 +1,32 @@
+#ifndef _ST7735_TILEMAP_H_
+#define _ST7735_TILEMAP_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// Tile edge in pixels, 8 or 16
+#define ST7735_TILE_SIZE 8
+
+// Map size in tiles, anchored at the screen origin. Tiles outside the
+// screen are kept but never sent.
+#define ST7735_TILEMAP_W 16
+#define ST7735_TILEMAP_H 16
+
+// Tile sheets are one tile wide with the tiles stacked vertically, in the
+// same layout as the images taken by st7735_draw_bitmap (uint16_t width,
+// height, RGB565 pixels) or st7735_draw_mono_bitmap (uint8_t width, height,
+// LSB first bits).
+void st7735_tilemap_set_tileset(const uint16_t *sheet);
+void st7735_tilemap_set_mono_tileset(const uint8_t *sheet, uint16_t color_set, uint16_t color_unset);
+
+void st7735_tilemap_set(uint8_t col, uint8_t row, uint8_t tile);
+uint8_t st7735_tilemap_get(uint8_t col, uint8_t row);
+void st7735_tilemap_fill(uint8_t tile);
+
+// Marks every tile for the next flush (e.g. after the tileset changed)
+void st7735_tilemap_invalidate(void);
+
+// Sends the dirty tiles, adjacent dirty tiles on a row through one window
+void st7735_tilemap_flush(void);
+
+#endif
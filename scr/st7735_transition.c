@@ -0,0 +1,157 @@
+#include "st7735_transition.h"
+
+#include "st7735.h"
+#include "st7735_dirty.h"
+#include "timebase.h"
+
+static inline uint8_t st7735_transition_height(const struct st7735_transition *tr) {
+	return tr->area.y1 - tr->area.y0 + 1;
+}
+
+static inline uint8_t st7735_transition_width(const struct st7735_transition *tr) {
+	return tr->area.x1 - tr->area.x0 + 1;
+}
+
+// Scroll offset after step k of n, the last one wraps around to the start
+static inline uint8_t st7735_transition_offset(const struct st7735_transition *tr, uint8_t k) {
+	uint8_t n = tr->steps - 1;
+	return k == n ? st7735_transition_height(tr) : k * ST7735_TRANSITION_SCROLL_STEP;
+}
+
+void st7735_transition_begin(struct st7735_transition *tr, enum ST7735_TRANSITION type, uint16_t color, uint16_t duration_ms) {
+	tr->area = st7735_clip.rect;
+	tr->color = color;
+	tr->duration_ms = duration_ms;
+	tr->start = timebase_now();
+	tr->step = 0;
+	tr->due = 0;
+
+	uint8_t whole = tr->area.x0 == 0 && tr->area.y0 == 0 &&
+		tr->area.x1 == st7735_width - 1 && tr->area.y1 == st7735_height - 1;
+	uint8_t height = st7735_transition_height(tr);
+
+	switch(type) {
+		case ST7735_TRANSITION_BLANK:
+		case ST7735_TRANSITION_FLASH:
+			if(whole) {
+				tr->steps = type == ST7735_TRANSITION_BLANK ? 2 : 3;
+				break;
+			}
+			// The display commands would hit the rest of the panel, wipe instead
+			type = ST7735_TRANSITION_ROW_WIPE;
+			tr->steps = ST7735_TRANSITION_BANDS;
+			break;
+
+		case ST7735_TRANSITION_SCROLL:
+			// Only the rows of the area scroll, the rest stays fixed
+			if(st7735_scroll_define(tr->area.y0, height)) {
+				uint8_t n = height / ST7735_TRANSITION_SCROLL_STEP;
+				tr->steps = (n ? n : 1) + 1;
+				break;
+			}
+			// No vertical scroll in landscape, wipe instead
+			type = ST7735_TRANSITION_ROW_WIPE;
+			tr->steps = ST7735_TRANSITION_BANDS;
+			break;
+
+		default:
+			tr->steps = ST7735_TRANSITION_BANDS;
+			break;
+	}
+
+	tr->type = type;
+}
+
+uint8_t st7735_transition_step(struct st7735_transition *tr) {
+	uint8_t step = tr->step++;
+	uint16_t d = tr->duration_ms;
+
+	switch(tr->type) {
+		case ST7735_TRANSITION_BLANK:
+			if(step == 0) {
+				st7735_display_on(0);
+				st7735_clear_dirty(tr->color);
+				tr->due = d;
+			} else {
+				st7735_display_on(1);
+			}
+			break;
+
+		case ST7735_TRANSITION_FLASH:
+			if(step == 0) {
+				st7735_invert_display(1);
+				tr->due = d / 2;
+			} else if(step == 1) {
+				st7735_display_on(0);
+				st7735_invert_display(0);
+				st7735_clear_dirty(tr->color);
+				tr->due = d;
+			} else {
+				st7735_display_on(1);
+			}
+			break;
+
+		case ST7735_TRANSITION_SCROLL: {
+			uint8_t n = tr->steps - 1;
+			if(step > 0) {
+				st7735_scroll_set(st7735_transition_offset(tr, step));
+			}
+			if(step < n) {
+				// Rows scrolled off the top reappear at the bottom: clear them first
+				uint8_t top = tr->area.y0 + step * ST7735_TRANSITION_SCROLL_STEP;
+				uint8_t bottom = tr->area.y0 + st7735_transition_offset(tr, step + 1) - 1;
+				st7735_clear_dirty_in(tr->area.x0, top, tr->area.x1, bottom, tr->color);
+				tr->due = (uint32_t)d * (step + 1) / n;
+			} else {
+				st7735_scroll_reset();
+			}
+			break;
+		}
+
+		case ST7735_TRANSITION_ROW_WIPE: {
+			uint8_t height = st7735_transition_height(tr);
+			uint8_t y0 = tr->area.y0 + (uint16_t)height * step / ST7735_TRANSITION_BANDS;
+			uint8_t y1 = tr->area.y0 + (uint16_t)height * (step + 1) / ST7735_TRANSITION_BANDS - 1;
+			if(y1 >= y0) {
+				st7735_clear_dirty_in(tr->area.x0, y0, tr->area.x1, y1, tr->color);
+			}
+			tr->due = (uint32_t)d * (step + 1) / ST7735_TRANSITION_BANDS;
+			break;
+		}
+
+		case ST7735_TRANSITION_COLUMN_WIPE: {
+			uint8_t width = st7735_transition_width(tr);
+			uint8_t x0 = tr->area.x0 + (uint16_t)width * step / ST7735_TRANSITION_BANDS;
+			uint8_t x1 = tr->area.x0 + (uint16_t)width * (step + 1) / ST7735_TRANSITION_BANDS - 1;
+			if(x1 >= x0) {
+				st7735_clear_dirty_in(x0, tr->area.y0, x1, tr->area.y1, tr->color);
+			}
+			tr->due = (uint32_t)d * (step + 1) / ST7735_TRANSITION_BANDS;
+			break;
+		}
+	}
+
+	if(tr->step < tr->steps) {
+		return 1;
+	}
+
+	st7735_dirty_reset();
+	return 0;
+}
+
+uint16_t st7735_transition_delay(const struct st7735_transition *tr) {
+	uint16_t elapsed = timebase_now() - tr->start;
+	return elapsed < tr->due ? tr->due - elapsed : 0;
+}
+
+void st7735_transition(enum ST7735_TRANSITION type, uint16_t color, uint16_t duration_ms) {
+	struct st7735_transition tr;
+
+	st7735_transition_begin(&tr, type, color, duration_ms);
+	while(st7735_transition_step(&tr)) {
+		uint16_t ms = st7735_transition_delay(&tr);
+		if(ms) {
+			timebase_sleep_ms(ms);
+		}
+	}
+}
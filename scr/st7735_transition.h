@@ -0,0 +1,51 @@
+#ifndef _ST7735_TRANSITION_H_
+#define _ST7735_TRANSITION_H_
+
+#include <stdint.h>
+
+#include "st7735.h"
+
+// Transitions clear everything drawn since the last clear (see
+// st7735_dirty.h) to a color over duration_ms, using timebase.h. They
+// work on the clip rectangle set when they begin, so a band outside of it
+// (a status line, ...) stays as it is.
+enum ST7735_TRANSITION {
+	ST7735_TRANSITION_BLANK,		// display off while clearing
+	ST7735_TRANSITION_FLASH,		// inverted flash, then blank while clearing
+	ST7735_TRANSITION_SCROLL,		// contents scroll up, color comes in from the bottom
+	ST7735_TRANSITION_ROW_WIPE,		// bands of rows, top to bottom
+	ST7735_TRANSITION_COLUMN_WIPE	// bands of columns, left to right
+};
+// BLANK and FLASH switch the whole panel, they become a row wipe when the
+// clip rectangle leaves part of it out. So does SCROLL in landscape.
+
+#define ST7735_TRANSITION_BANDS 8
+#define ST7735_TRANSITION_SCROLL_STEP 4	// rows per scroll step
+
+struct st7735_transition {
+	uint8_t type;
+	uint8_t step, steps;
+	uint16_t color;
+	uint16_t duration_ms;
+	uint16_t start;
+	uint16_t due;			// ms after start the next step is due
+	struct st7735_rect area;	// screen coordinates
+};
+
+// Step by step, so a task can sleep in between and the others keep
+// running:
+//
+//   st7735_transition_begin(&tr, ST7735_TRANSITION_SCROLL, ST7735_COLOR_BLACK, 400);
+//   while(st7735_transition_step(&tr))
+//   	TASK_SLEEP_MS(t, st7735_transition_delay(&tr));
+//
+// step returns 0 after the last step, delay is 0 when the next one is
+// late already.
+void st7735_transition_begin(struct st7735_transition *tr, enum ST7735_TRANSITION type, uint16_t color, uint16_t duration_ms);
+uint8_t st7735_transition_step(struct st7735_transition *tr);
+uint16_t st7735_transition_delay(const struct st7735_transition *tr);
+
+// All steps at once, sleeping in between
+void st7735_transition(enum ST7735_TRANSITION type, uint16_t color, uint16_t duration_ms);
+
+#endif
@@ -0,0 +1,46 @@
+#include "stack.h"
+
+#include <avr/io.h>
+
+#define STACK_CANARY 0xC5
+
+extern uint8_t _end;	// first byte after .bss, start of the heap
+extern uint8_t __stack;	// RAMEND
+
+void stack_paint(void) __attribute__((naked, used, section(".init1")));
+
+// Runs straight from the reset code, before the stack pointer and r1 are
+// set up, so no C: fills _end .. RAMEND with the canary
+void stack_paint(void) {
+	__asm__ volatile (
+		"ldi r30, lo8(_end)\n\t"
+		"ldi r31, hi8(_end)\n\t"
+		"ldi r24, %[canary]\n\t"
+		"ldi r25, hi8(__stack + 1)\n\t"
+		"rjmp 2f\n"
+	"1:\n\t"
+		"st Z+, r24\n"
+	"2:\n\t"
+		"cpi r30, lo8(__stack + 1)\n\t"
+		"cpc r31, r25\n\t"
+		"brlo 1b\n\t"
+		:
+		: [canary] "M" (STACK_CANARY)
+	);
+}
+
+uint16_t stack_unused(void) {
+	const uint8_t *p = &_end;
+	while(p <= &__stack && *p == STACK_CANARY) {
+		p++;
+	}
+	return p - &_end;
+}
+
+uint16_t stack_high_water(void) {
+	return (uint16_t)(&__stack - &_end) + 1 - stack_unused();
+}
+
+uint16_t stack_free(void) {
+	return SP - (uint16_t)&_end;
+}
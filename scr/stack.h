@@ -0,0 +1,25 @@
+#ifndef _STACK_H_
+#define _STACK_H_
+
+#include <stdint.h>
+
+// Stack usage. At reset, before anything else runs, all SRAM above .bss
+// is filled with a pattern; the stack overwrites it as it grows. How much
+// of the pattern is left tells how close the stack ever came to the
+// variables (or the heap, if malloc is used).
+//
+// Linking stack.c is all it takes, the painting runs by itself. The
+// static RAM of every module is listed after each build by
+// tools/memory_report.py, which also fails the build when .data and .bss
+// leave less than custom_stack_reserve (platformio.ini) for the stack.
+
+// Bytes between the end of .bss and the deepest the stack has been
+uint16_t stack_unused(void);
+
+// Most bytes the stack has used so far
+uint16_t stack_high_water(void);
+
+// Bytes between the end of .bss and the stack pointer right now
+uint16_t stack_free(void);
+
+#endif
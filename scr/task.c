@@ -0,0 +1,55 @@
+#include "task.h"
+
+#include <stddef.h>
+#include <avr/sleep.h>
+
+static struct task *task_list = NULL;
+
+void task_add(struct task *t, enum TASK_STATE (*run)(struct task *t)) {
+	t->run = run;
+	t->resume = NULL;
+	t->state = TASK_READY;
+
+	// Appended, so tasks run in the order they were added
+	t->next = NULL;
+	struct task **link = &task_list;
+	while(*link) {
+		link = &(*link)->next;
+	}
+	*link = t;
+}
+
+void task_run(void) {
+	set_sleep_mode(SLEEP_MODE_IDLE);
+
+	while(task_list) {
+		uint8_t ready = 0;
+		uint16_t now = timebase_now();
+
+		struct task **link = &task_list;
+		while(*link) {
+			struct task *t = *link;
+
+			if(t->state == TASK_SLEEPING && (int16_t)(now - t->wake) < 0) {
+				link = &t->next;
+				continue;
+			}
+
+			t->state = t->run(t);
+
+			if(t->state == TASK_DONE) {
+				*link = t->next;
+				continue;
+			}
+			if(t->state == TASK_READY) {
+				ready = 1;
+			}
+			link = &t->next;
+		}
+
+		// An interrupt right before this only costs up to one tick
+		if(!ready) {
+			sleep_mode();
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef _TASK_H_
+#define _TASK_H_
+
+#include <stdint.h>
+
+#include "timebase.h"
+
+// Stackless cooperative tasks (protothreads). A task is a function that
+// is called again and again; the macros below return from it and jump
+// back to where it left off on the next call:
+//
+//   struct blink { struct task task; uint8_t n; };	// task comes first
+//
+//   enum TASK_STATE blink_run(struct task *t) {
+//   	struct blink *b = (struct blink *)t;
+//   	TASK_BEGIN(t);
+//   	for(b->n = 0; b->n < 10; b->n++) {
+//   		PORTD ^= (1 << PD7);
+//   		TASK_SLEEP_MS(t, 500);
+//   	}
+//   	TASK_END(t);
+//   }
+//
+// Local variables do not survive a wait, keep them in the task struct.
+// Uses GCC label addresses, so waits may sit inside switch statements,
+// but only one wait per source line.
+
+enum TASK_STATE {
+	TASK_READY,		// run again on the next pass
+	TASK_WAITING,	// condition polled after every interrupt
+	TASK_SLEEPING,	// until the timebase reaches wake
+	TASK_DONE		// removed from the run queue
+};
+
+struct task {
+	enum TASK_STATE (*run)(struct task *t);
+	void *resume;	// label to continue at, NULL at the start
+	uint16_t wake;
+	uint8_t state;
+	struct task *next;
+};
+
+#define TASK_LABEL2(line) task_resume_ ## line
+#define TASK_LABEL(line) TASK_LABEL2(line)
+
+#define TASK_BEGIN(t) do { if((t)->resume) goto *(t)->resume; } while(0)
+
+#define TASK_END(t) do { (t)->resume = 0; return TASK_DONE; } while(0)
+
+// Lets the other tasks run once
+#define TASK_YIELD(t) do { \
+	(t)->resume = &&TASK_LABEL(__LINE__); \
+	return TASK_READY; \
+	TASK_LABEL(__LINE__):; \
+} while(0)
+
+// Waits ms milliseconds (up to 32767) without blocking the others
+#define TASK_SLEEP_MS(t, ms) do { \
+	(t)->wake = timebase_now() + (ms); \
+	(t)->resume = &&TASK_LABEL(__LINE__); \
+	return TASK_SLEEPING; \
+	TASK_LABEL(__LINE__):; \
+} while(0)
+
+// Waits for a condition set by an interrupt (or another task)
+#define TASK_WAIT_UNTIL(t, cond) do { \
+	(t)->resume = &&TASK_LABEL(__LINE__); \
+	TASK_LABEL(__LINE__): \
+	if(!(cond)) { \
+		return TASK_WAITING; \
+	} \
+} while(0)
+
+// Adds a task to the run queue, it starts from the top
+void task_add(struct task *t, enum TASK_STATE (*run)(struct task *t));
+
+// Runs the queued tasks until all are done. Whenever none is ready the
+// CPU idles until the next interrupt (at the latest the 1 ms tick), so
+// timebase_init() has to be called first.
+void task_run(void);
+
+#endif
@@ -0,0 +1,45 @@
+#include "timebase.h"
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+// 1 ms with clk/8: F_CPU / 8 / 1000 counts per tick
+#define TIMEBASE_TOP (F_CPU / 8 / 1000 - 1)
+
+#if TIMEBASE_TOP > 255
+#error "Timer2 cannot reach 1 ms with clk/8 at this F_CPU"
+#endif
+
+static volatile uint16_t timebase_ms = 0;
+
+ISR(TIMER2_COMPA_vect) {
+	timebase_ms++;
+}
+
+void timebase_init(void) {
+	// CTC mode, clk/8, interrupt on compare match A
+	TCCR2A = (1 << WGM21);
+	TCCR2B = (1 << CS21);
+	OCR2A = TIMEBASE_TOP;
+	TIMSK2 = (1 << OCIE2A);
+}
+
+uint16_t timebase_now(void) {
+	uint16_t now;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		now = timebase_ms;
+	}
+	return now;
+}
+
+void timebase_sleep_ms(uint16_t ms) {
+	uint16_t start = timebase_now();
+
+	// Idle keeps the timers and SPI clocked, the CPU core stops
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	while((uint16_t)(timebase_now() - start) < ms) {
+		sleep_mode();
+	}
+}
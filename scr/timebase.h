@@ -0,0 +1,17 @@
+#ifndef _TIMEBASE_H_
+#define _TIMEBASE_H_
+
+#include <stdint.h>
+
+// Millisecond tick on Timer2 (CTC), Timer0 is left to the application.
+void timebase_init(void);
+
+// Milliseconds since init, wraps every 65.5 s; compare with differences:
+//   if((uint16_t)(timebase_now() - start) >= duration) ...
+uint16_t timebase_now(void);
+
+// Waits ms milliseconds with the CPU in idle sleep between ticks.
+// Other interrupts keep running (and wake the CPU early, it sleeps again).
+void timebase_sleep_ms(uint16_t ms);
+
+#endif
@@ -0,0 +1,105 @@
+"""PlatformIO extra script: static RAM per module after every build.
+
+Lists the .data and .bss bytes each object file brings into the linked
+firmware (from the linker map, so sections dropped by --gc-sections do
+not count) and fails the build when the stack would get less than
+custom_stack_reserve bytes of the SRAM. In platformio.ini:
+
+    extra_scripts = post:tools/memory_report.py
+    custom_stack_reserve = 512
+
+Constant tables not in PROGMEM end up in .data (they are copied to SRAM
+at startup) and are counted there.
+"""
+
+import os
+import re
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+RAM_SIZE = 2048  # ATmega328P
+
+MAP_FILE = os.path.join(env.subst("$BUILD_DIR"), "firmware.map")  # noqa: F821
+env.Append(LINKFLAGS=["-Wl,-Map," + MAP_FILE])  # noqa: F821
+
+# "<section> <address> <size> <object>", the name may stand on its own line
+INPUT = re.compile(r"^ (\.\S+|COMMON)?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S+)$")
+OUTPUT = re.compile(r"^(\.\S+)\s")
+
+
+def module_name(path):
+    name = os.path.basename(path)
+    archive = re.match(r"(.*)\.a\((.*)\)$", name)
+    if archive:
+        return archive.group(1)  # libc, libgcc, ...
+    return re.sub(r"\.(c|cpp|S)?\.?o$", "", name)
+
+
+def parse_map(path):
+    usage = {}  # module -> [data, bss]
+    output = None
+    pending = None
+    in_memory_map = False
+
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("Linker script and memory map"):
+                in_memory_map = True
+                continue
+            if not in_memory_map:
+                continue
+
+            match = OUTPUT.match(line)
+            if match:
+                output = match.group(1)
+                continue
+            if output not in (".data", ".bss", ".noinit"):
+                continue
+
+            stripped = line.strip()
+            if line.startswith(" .") and " " not in stripped:
+                pending = stripped  # input section name, the rest follows
+                continue
+
+            match = INPUT.match(line)
+            if not match or (match.group(1) is None and pending is None):
+                pending = None
+                continue
+            pending = None
+
+            size = int(match.group(3), 16)
+            if size == 0:
+                continue
+            counts = usage.setdefault(module_name(match.group(4)), [0, 0])
+            counts[0 if output == ".data" else 1] += size
+
+    return usage
+
+
+def report(source, target, env):
+    if not os.path.isfile(MAP_FILE):
+        print("memory_report: no linker map, skipped")
+        return
+
+    usage = parse_map(MAP_FILE)
+    reserve = int(env.GetProjectOption("custom_stack_reserve", "512"))
+
+    print("\nStatic RAM per module (bytes)")
+    print("  %-24s %6s %6s %6s" % ("module", "data", "bss", "total"))
+    total_data = total_bss = 0
+    for name, (data, bss) in sorted(usage.items(), key=lambda item: -sum(item[1])):
+        print("  %-24s %6d %6d %6d" % (name, data, bss, data + bss))
+        total_data += data
+        total_bss += bss
+    static = total_data + total_bss
+    print("  %-24s %6d %6d %6d" % ("total", total_data, total_bss, static))
+
+    left = RAM_SIZE - static
+    print("  %d bytes left for stack and heap, %d reserved\n" % (left, reserve))
+    if left < reserve:
+        print("memory_report: static RAM leaves less than custom_stack_reserve")
+        env.Exit(1)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report)  # noqa: F821
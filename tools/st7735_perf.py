@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Decodes the telemetry of a -DST7735_PERF build (see scr/st7735_perf.h).
+
+Reads from a serial port (needs pyserial) or a file with a capture of the
+stream, and prints what the drawing primitives cost per tag, i.e. per
+animation:
+
+    python3 tools/st7735_perf.py /dev/ttyUSB0
+    python3 tools/st7735_perf.py capture.bin
+
+The table is printed again every --every frames and at the end (Ctrl-C).
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+BAUD = 9600
+
+# enum ST7735_PERF_ID
+PRIMITIVES = ["pixel", "fill rect", "gradient", "bitmap", "mono bitmap",
+              "line", "rect", "circle", "text"]
+
+# Tags sent by main.c
+TAGS = {0: "circles", 1: "rectangles", 2: "big star", 3: "stars",
+        4: "clock animation", 5: "clock widget"}
+
+HEADER = struct.Struct("<BBHI")     # tag, dropped, stack unused, frame cycles
+RECORD = struct.Struct("<BHHIII")   # id, calls, windows, pixels, bytes, cycles
+
+
+def frames(read):
+    """Yields the payloads of all frames with a correct checksum."""
+    while True:
+        byte = read(1)
+        if not byte:
+            return
+        if byte[0] != 0xA5:
+            continue
+        byte = read(1)
+        if not byte or byte[0] != 0x5A:
+            continue
+        length = read(1)
+        if not length:
+            return
+        payload = read(length[0])
+        checksum = read(1)
+        if len(payload) != length[0] or not checksum:
+            return
+        if sum(payload) & 0xFF == checksum[0]:
+            yield payload
+
+
+class Totals:
+    def __init__(self):
+        self.frames = 0
+        self.cycles = 0
+        self.dropped = 0
+        self.stack_unused = None
+        self.primitives = {}    # id -> [calls, windows, pixels, bytes, cycles]
+
+    def add(self, payload):
+        tag, dropped, stack_unused, cycles = HEADER.unpack_from(payload)
+        self.frames += 1
+        self.cycles += cycles
+        self.dropped = dropped
+        self.stack_unused = stack_unused
+        for offset in range(HEADER.size, len(payload) - RECORD.size + 1, RECORD.size):
+            record = RECORD.unpack_from(payload, offset)
+            counts = self.primitives.setdefault(record[0], [0] * 5)
+            for i, value in enumerate(record[1:]):
+                counts[i] += value
+        return tag
+
+
+def print_tables(totals, out=sys.stdout):
+    for tag in sorted(totals):
+        t = totals[tag]
+        name = TAGS.get(tag, "tag %d" % tag)
+        drawn = sum(c[4] for c in t.primitives.values())
+        share = 100.0 * drawn / t.cycles if t.cycles else 0.0
+        out.write("\n%s: %d frames, %.0f cycles/frame, %.0f%% drawing\n"
+                  % (name, t.frames, t.cycles / t.frames, share))
+        out.write("  %-12s %8s %8s %10s %10s %12s %8s\n"
+                  % ("primitive", "calls", "windows", "pixels", "bytes", "cycles", "cyc/px"))
+        for pid in sorted(t.primitives):
+            calls, windows, pixels, nbytes, cycles = t.primitives[pid]
+            pname = PRIMITIVES[pid] if pid < len(PRIMITIVES) else "id %d" % pid
+            per_pixel = "%.1f" % (cycles / pixels) if pixels else "-"
+            out.write("  %-12s %8d %8d %10d %10d %12d %8s\n"
+                      % (pname, calls, windows, pixels, nbytes, cycles, per_pixel))
+    if totals:
+        unused = min(t.stack_unused for t in totals.values())
+        out.write("\nstack: %d bytes never used (SRAM left above .bss)\n" % unused)
+    dropped = max((t.dropped for t in totals.values()), default=0)
+    if dropped:
+        out.write("\n%d frames dropped on the device (buffer full)\n" % dropped)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="serial port or capture file")
+    parser.add_argument("--baud", type=int, default=BAUD)
+    parser.add_argument("--every", type=int, default=20,
+                        help="print the tables every N frames (0: only at the end)")
+    args = parser.parse_args()
+
+    if os.path.isfile(args.source):
+        stream = open(args.source, "rb")
+    else:
+        import serial
+        stream = serial.Serial(args.source, args.baud)
+
+    totals = {}
+    count = 0
+    try:
+        for payload in frames(stream.read):
+            tag = payload[0]
+            totals.setdefault(tag, Totals()).add(payload)
+            count += 1
+            if args.every and count % args.every == 0:
+                print_tables(totals)
+    except KeyboardInterrupt:
+        pass
+    print_tables(totals)
+
+
+if __name__ == "__main__":
+    main()